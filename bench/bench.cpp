@@ -0,0 +1,499 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#define OOF_IMPL
+#include "../oof.h"
+#include "../tests/vt_emulator.h"
+
+
+// Counts every heap allocation of the process. Only the ones during get_string() are reported
+namespace {
+   size_t allocation_count = 0;
+}
+
+auto operator new(const size_t size) -> void*
+{
+   ++allocation_count;
+   if (void* const ptr = std::malloc(size == 0 ? 1 : size))
+      return ptr;
+   throw std::bad_alloc{};
+}
+
+auto operator delete(void* ptr) noexcept -> void
+{
+   std::free(ptr);
+}
+
+auto operator delete(void* ptr, size_t) noexcept -> void
+{
+   std::free(ptr);
+}
+
+
+namespace {
+
+   // Deterministic and cheap, so the workloads are the same on every machine and standard library
+   struct xorshift {
+      uint32_t m_state = 2463534242u;
+
+      auto operator()() -> uint32_t {
+         m_state ^= m_state << 13;
+         m_state ^= m_state >> 17;
+         m_state ^= m_state << 5;
+         return m_state;
+      }
+
+      // In [0, 1)
+      auto get_float() -> float {
+         return static_cast<float>((*this)() >> 8) / 16777216.0f;
+      }
+   };
+
+
+   struct bench_result {
+      const char* m_name = nullptr;
+      const char* m_canvas = nullptr;
+      int m_width = 0;
+      int m_height = 0;
+      double m_diff_ns = 0.0;
+      double m_serialization_ns = 0.0;
+      double m_code_serialization_ns = 0.0;
+      double m_total_ns = 0.0;
+      double m_bytes = 0.0;
+      double m_allocations = 0.0;
+      double m_variant_bytes = 0.0;
+      double m_code_bytes = 0.0;
+      std::array<double, oof::testing::sequence_kind_count> m_bytes_by_kind{};
+   };
+
+
+   // What the terminal receives. Wide strings get written as UTF-8
+   auto get_byte_count(const std::string& str) -> size_t
+   {
+      return str.size();
+   }
+   auto get_byte_count(const std::wstring& str) -> size_t
+   {
+      size_t result = 0;
+      for (const wchar_t letter : str)
+      {
+         const auto code_point = static_cast<uint32_t>(letter);
+         if (code_point < 0x80)         result += 1;
+         else if (code_point < 0x800)   result += 2;
+         else if (code_point < 0x10000) result += 3;
+         else                           result += 4;
+      }
+      return result;
+   }
+
+
+   // Calls update(canvas, frame) before every frame and times get_string(). The serialization part is measured by
+   // writing the sequences of the frame again, the diff is the rest. The output is also fed into a terminal emulator
+   // to see which kinds of sequences the bytes go to. The sequences are also converted into a sequence_code_buffer to
+   // compare its size and serialization time with the variant vector
+   template<typename canvas_type, typename update_type>
+   auto run_workload(
+      const char* name, const char* canvas_name,
+      canvas_type& canvas,
+      const int terminal_height,
+      const int frame_count,
+      update_type&& update
+   ) -> bench_result
+   {
+      using clock = std::chrono::steady_clock;
+      using string_type = std::remove_cvref_t<decltype(canvas.get_string())>;
+
+      constexpr int warmup_frames = 10;
+      string_type buffer;
+      string_type serialization_buffer;
+      clock::duration total_time{};
+      clock::duration serialization_time{};
+      clock::duration code_serialization_time{};
+      size_t byte_count = 0;
+      size_t allocations = 0;
+      size_t variant_byte_count = 0;
+      size_t code_byte_count = 0;
+      oof::sequence_code_buffer code;
+      oof::testing::vt_emulator<string_type> emulator(canvas.get_width(), terminal_height);
+      for (int frame = 0; frame < warmup_frames + frame_count; ++frame)
+      {
+         update(canvas, frame);
+
+         const size_t allocations_before = allocation_count;
+         const auto t0 = clock::now();
+         canvas.get_string(buffer);
+         const auto t1 = clock::now();
+         const size_t frame_allocations = allocation_count - allocations_before;
+
+         serialization_buffer.reserve(buffer.capacity());
+         const auto t2 = clock::now();
+         serialization_buffer.clear();
+         oof::detail::write_sequence_string_no_reserve(canvas.get_sequences(), serialization_buffer);
+         const auto t3 = clock::now();
+
+         code.clear();
+         for (const oof::sequence_variant_type& sequence : canvas.get_sequences())
+            code.push_back(sequence);
+         const auto t4 = clock::now();
+         serialization_buffer.clear();
+         oof::write_sequences_into_string(serialization_buffer, code);
+         const auto t5 = clock::now();
+
+         emulator.write(buffer);
+         if (frame < warmup_frames)
+         {
+            emulator.reset_stats();
+            continue;
+         }
+         total_time += t1 - t0;
+         serialization_time += t3 - t2;
+         code_serialization_time += t5 - t4;
+         variant_byte_count += canvas.get_sequences().size() * sizeof(oof::sequence_variant_type);
+         code_byte_count += code.get_byte_size();
+         byte_count += get_byte_count(buffer);
+         allocations += frame_allocations;
+      }
+
+      const auto get_ns_per_frame = [&](const clock::duration time) {
+         return std::chrono::duration<double, std::nano>(time).count() / frame_count;
+      };
+      bench_result result;
+      result.m_name = name;
+      result.m_canvas = canvas_name;
+      result.m_total_ns = get_ns_per_frame(total_time);
+      result.m_serialization_ns = get_ns_per_frame(serialization_time);
+      result.m_code_serialization_ns = get_ns_per_frame(code_serialization_time);
+      result.m_diff_ns = std::max(result.m_total_ns - result.m_serialization_ns, 0.0);
+      result.m_bytes = static_cast<double>(byte_count) / frame_count;
+      result.m_allocations = static_cast<double>(allocations) / frame_count;
+      result.m_variant_bytes = static_cast<double>(variant_byte_count) / frame_count;
+      result.m_code_bytes = static_cast<double>(code_byte_count) / frame_count;
+      for (int i = 0; i < oof::testing::sequence_kind_count; ++i)
+         result.m_bytes_by_kind[i] = static_cast<double>(emulator.get_stats(static_cast<oof::testing::sequence_kind>(i)).m_bytes) / frame_count;
+      return result;
+   }
+
+
+   struct stream_result {
+      const char* m_name = nullptr;
+      const char* m_stream = nullptr;
+      int m_sequence_count = 0;
+      double m_ns_per_sequence = 0.0;
+      double m_bytes_per_pass = 0.0; // Including the text
+      double m_allocations_per_sequence = 0.0;
+   };
+
+
+   // Throws away everything, so that only the formatting is measured
+   template<typename char_type>
+   struct discarding_streambuf : std::basic_streambuf<char_type> {
+      size_t m_byte_count = 0;
+
+   protected:
+      auto xsputn(const char_type*, const std::streamsize count) -> std::streamsize override {
+         m_byte_count += static_cast<size_t>(count);
+         return count;
+      }
+      auto overflow(const typename std::basic_streambuf<char_type>::int_type letter) -> typename std::basic_streambuf<char_type>::int_type override {
+         ++m_byte_count;
+         return std::char_traits<char_type>::not_eof(letter);
+      }
+   };
+
+
+   // A colored log through the simple interface: Every line is positioned, colored and reset, 10k sequences per pass
+   template<typename char_type>
+   auto bench_log_stream(const char* stream_name, const int pass_count) -> stream_result
+   {
+      using clock = std::chrono::steady_clock;
+      constexpr int line_count = 2500;
+      constexpr int sequences_per_line = 4;
+      constexpr char_type text[] = { 'l', 'o', 'g', ' ', 'e', 'n', 't', 'r', 'y', '\n', '\0' };
+
+      discarding_streambuf<char_type> sink;
+      std::basic_ostream<char_type> os(&sink);
+      const auto write_pass = [&] {
+         for (int line = 0; line < line_count; ++line)
+         {
+            os << oof::position(line % 50, 2);
+            os << oof::fg_color(oof::color{ line % 256, 255 - line % 256, 128 });
+            os << oof::bold(line % 7 == 0);
+            os << text;
+            os << oof::reset_formatting();
+         }
+      };
+
+      write_pass();
+      sink.m_byte_count = 0;
+      const size_t allocations_before = allocation_count;
+      const auto t0 = clock::now();
+      for (int pass = 0; pass < pass_count; ++pass)
+         write_pass();
+      const auto t1 = clock::now();
+
+      const double sequence_count = static_cast<double>(line_count) * sequences_per_line * pass_count;
+      stream_result result;
+      result.m_name = "log_stream";
+      result.m_stream = stream_name;
+      result.m_sequence_count = line_count * sequences_per_line;
+      result.m_ns_per_sequence = std::chrono::duration<double, std::nano>(t1 - t0).count() / sequence_count;
+      result.m_bytes_per_pass = static_cast<double>(sink.m_byte_count) / pass_count;
+      result.m_allocations_per_sequence = static_cast<double>(allocation_count - allocations_before) / sequence_count;
+      return result;
+   }
+
+
+   template<typename canvas_type>
+   auto with_size(bench_result result, const canvas_type& canvas, const int height) -> bench_result
+   {
+      result.m_width = canvas.get_width();
+      result.m_height = height;
+      return result;
+   }
+
+
+   // pixel_screens have two pixels per line
+   auto get_terminal_height(const oof::pixel_screen& px) -> int
+   {
+      return px.get_halfline_height() / 2 + 1;
+   }
+
+
+   // A long text that moves one column per frame, like a news ticker over the whole screen
+   auto bench_text_crawl(const int frame_count) -> bench_result
+   {
+      oof::screen<std::string> scr(120, 40, 0, 0, ' ');
+      const std::string text = "The quick brown fox jumps over the lazy dog. Pack my box with five dozen liquor jugs! ";
+      const auto result = run_workload("text_crawl", "screen<std::string>", scr, scr.get_height(), frame_count, [&](auto& canvas, const int frame) {
+         for (int line = 0; line < canvas.get_height(); ++line)
+         {
+            for (int column = 0; column < canvas.get_width(); ++column)
+            {
+               oof::cell<std::string>& cell = canvas.get_cell(column, line);
+               cell.m_letter = text[(column + frame + line * 7) % text.size()];
+               cell.m_format.m_fg_color = oof::color{ 200, 200, 100 + line * 3 };
+            }
+         }
+      });
+      return with_size(result, scr, scr.get_height());
+   }
+
+
+   // Colored bars of changing length on every line, like the bars demo
+   auto bench_bars(const int frame_count) -> bench_result
+   {
+      oof::screen<std::string> scr(100, 30, 0, 0, ' ');
+      const auto result = run_workload("bars", "screen<std::string>", scr, scr.get_height(), frame_count, [&](auto& canvas, const int frame) {
+         const int width = canvas.get_width();
+         for (int line = 0; line < canvas.get_height(); ++line)
+         {
+            const double phase = 0.05 * frame + 0.4 * line;
+            const int bar_length = static_cast<int>((0.5 + 0.5 * std::sin(phase)) * width);
+            const oof::color bar_color{ line * 8, 150, 255 - line * 8 };
+            for (int column = 0; column < width; ++column)
+            {
+               oof::cell<std::string>& cell = canvas.get_cell(column, line);
+               cell.m_letter = ' ';
+               cell.m_format.m_bg_color = column < bar_length ? bar_color : oof::color{};
+            }
+         }
+      });
+      return with_size(result, scr, scr.get_height());
+   }
+
+
+   struct particle {
+      float m_x = 0.0f;
+      float m_y = 0.0f;
+      float m_vx = 0.0f;
+      float m_vy = 0.0f;
+      oof::color m_color{};
+   };
+
+
+   // Fading pixels with bursts of particles that fall down
+   auto bench_fireworks(const int frame_count) -> bench_result
+   {
+      oof::pixel_screen px(160, 100);
+      std::vector<particle> particles;
+      xorshift rng;
+      const auto result = run_workload("fireworks", "pixel_screen", px, get_terminal_height(px), frame_count, [&](auto& canvas, const int frame) {
+         for (oof::color& pixel : canvas)
+            pixel = oof::color{ pixel.red * 7 / 8, pixel.green * 7 / 8, pixel.blue * 7 / 8 };
+
+         if (frame % 15 == 0)
+         {
+            const float x = 20.0f + rng.get_float() * 120.0f;
+            const float y = 10.0f + rng.get_float() * 40.0f;
+            const oof::color col{ rng() % 256, rng() % 256, 255u };
+            for (int i = 0; i < 150; ++i)
+            {
+               const float angle = rng.get_float() * 6.2831853f;
+               const float speed = rng.get_float() * 2.0f;
+               particles.push_back(particle{ x, y, speed * std::cos(angle), speed * std::sin(angle), col });
+            }
+         }
+         std::erase_if(particles, [&](particle& p) {
+            p.m_vy += 0.05f;
+            p.m_x += p.m_vx;
+            p.m_y += p.m_vy;
+            const int column = static_cast<int>(p.m_x);
+            const int halfline = static_cast<int>(p.m_y);
+            if (canvas.is_in(column, halfline) == false)
+               return true;
+            canvas.get_color_unchecked(column, halfline) = p.m_color;
+            return false;
+         });
+      });
+      return with_size(result, px, px.get_halfline_height());
+   }
+
+
+   // Flakes that fall with some sideways drift over a static background
+   auto bench_snow(const int frame_count) -> bench_result
+   {
+      oof::pixel_screen px(160, 100);
+      std::vector<particle> flakes(600);
+      xorshift rng;
+      for (particle& flake : flakes)
+         flake = particle{ rng.get_float() * 160.0f, rng.get_float() * 100.0f, 0.0f, 0.2f + rng.get_float() * 0.5f, oof::color{ 255 } };
+      const auto result = run_workload("snow", "pixel_screen", px, get_terminal_height(px), frame_count, [&](auto& canvas, const int frame) {
+         for (int halfline = 0; halfline < canvas.get_halfline_height(); ++halfline)
+            std::ranges::fill(canvas.get_row(halfline), oof::color{ 0, 0, halfline });
+         for (particle& flake : flakes)
+         {
+            flake.m_y += flake.m_vy;
+            flake.m_x += 0.3f * std::sin(0.1f * frame + flake.m_vy * 20.0f);
+            if (flake.m_y >= 100.0f)
+               flake.m_y -= 100.0f;
+            const int column = static_cast<int>(flake.m_x);
+            const int halfline = static_cast<int>(flake.m_y);
+            if (canvas.is_in(column, halfline))
+               canvas.get_color_unchecked(column, halfline) = flake.m_color;
+         }
+      });
+      return with_size(result, px, px.get_halfline_height());
+   }
+
+
+   // Rotating line that leaves a fading trail, like the radar demo
+   auto bench_radar(const int frame_count) -> bench_result
+   {
+      oof::pixel_screen px(160, 160);
+      const auto result = run_workload("radar", "pixel_screen", px, get_terminal_height(px), frame_count, [&](auto& canvas, const int frame) {
+         for (oof::color& pixel : canvas)
+            pixel.green = static_cast<uint8_t>(pixel.green * 15 / 16);
+         const double angle = 0.05 * frame;
+         const int radius = 78;
+         canvas.draw_line(
+            80, 80,
+            80 + static_cast<int>(radius * std::cos(angle)), 80 + static_cast<int>(radius * std::sin(angle)),
+            oof::color{ 0, 255, 0 }
+         );
+         canvas.draw_circle(80, 80, radius, oof::color{ 0, 120, 0 });
+      });
+      return with_size(result, px, px.get_halfline_height());
+   }
+
+
+   // Every cell changes its letter and colors in every frame. The worst case
+   auto bench_noise(const int frame_count) -> bench_result
+   {
+      oof::screen<std::string> scr(120, 40, 0, 0, ' ');
+      xorshift rng;
+      const auto result = run_workload("noise", "screen<std::string>", scr, scr.get_height(), frame_count, [&](auto& canvas, const int) {
+         for (oof::cell<std::string>& cell : canvas)
+         {
+            cell.m_letter = static_cast<char>('a' + rng() % 26);
+            cell.m_format.m_fg_color = oof::color{ static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng()) };
+            cell.m_format.m_bg_color = oof::color{ static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng()), static_cast<uint8_t>(rng()) };
+         }
+      });
+      return with_size(result, scr, scr.get_height());
+   }
+
+
+   // Nothing changes after the first frame. Measures the cost of the diff alone
+   auto bench_static(const int frame_count) -> bench_result
+   {
+      oof::screen<std::string> scr(120, 40, 0, 0, ' ');
+      scr.write_into("static content", 5, 5, oof::cell_format{});
+      const auto result = run_workload("static", "screen<std::string>", scr, scr.get_height(), frame_count, [](auto&, const int) {});
+      return with_size(result, scr, scr.get_height());
+   }
+
+
+   auto print_json(const std::vector<bench_result>& results, const std::vector<stream_result>& stream_results, const int frame_count) -> void
+   {
+      std::printf("{\n   \"frames\": %d,\n   \"benchmarks\": [\n", frame_count);
+      for (size_t i = 0; i < results.size(); ++i)
+      {
+         const bench_result& result = results[i];
+         std::printf(
+            "      {\"name\": \"%s\", \"canvas\": \"%s\", \"width\": %d, \"height\": %d, "
+            "\"diff_ns_per_frame\": %.1f, \"serialization_ns_per_frame\": %.1f, \"total_ns_per_frame\": %.1f, "
+            "\"bytes_per_frame\": %.1f, \"allocations_per_frame\": %.2f, "
+            "\"variant_buffer_bytes_per_frame\": %.1f, \"code_buffer_bytes_per_frame\": %.1f, \"code_serialization_ns_per_frame\": %.1f, "
+            "\"bytes_per_frame_by_kind\": {",
+            result.m_name, result.m_canvas, result.m_width, result.m_height,
+            result.m_diff_ns, result.m_serialization_ns, result.m_total_ns,
+            result.m_bytes, result.m_allocations,
+            result.m_variant_bytes, result.m_code_bytes, result.m_code_serialization_ns
+         );
+         for (int kind = 0; kind < oof::testing::sequence_kind_count; ++kind)
+         {
+            std::printf(
+               "\"%s\": %.1f%s",
+               oof::testing::get_kind_name(static_cast<oof::testing::sequence_kind>(kind)),
+               result.m_bytes_by_kind[kind],
+               kind + 1 < oof::testing::sequence_kind_count ? ", " : ""
+            );
+         }
+         std::printf("}}%s\n", i + 1 < results.size() ? "," : "");
+      }
+      std::printf("   ],\n   \"streams\": [\n");
+      for (size_t i = 0; i < stream_results.size(); ++i)
+      {
+         const stream_result& result = stream_results[i];
+         std::printf(
+            "      {\"name\": \"%s\", \"stream\": \"%s\", \"sequences_per_pass\": %d, "
+            "\"ns_per_sequence\": %.2f, \"bytes_per_pass\": %.1f, \"allocations_per_sequence\": %.3f}%s\n",
+            result.m_name, result.m_stream, result.m_sequence_count,
+            result.m_ns_per_sequence, result.m_bytes_per_pass, result.m_allocations_per_sequence,
+            i + 1 < stream_results.size() ? "," : ""
+         );
+      }
+      std::printf("   ]\n}\n");
+   }
+
+} // namespace {}
+
+
+// Takes the number of measured frames per workload as the only, optional argument. It's also the number of passes of
+// the stream workloads. Writes JSON to stdout
+auto main(const int argc, char** argv) -> int
+{
+   const int frame_count = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 300;
+   const std::vector<bench_result> results{
+      bench_text_crawl(frame_count),
+      bench_bars(frame_count),
+      bench_fireworks(frame_count),
+      bench_snow(frame_count),
+      bench_radar(frame_count),
+      bench_noise(frame_count),
+      bench_static(frame_count)
+   };
+   const std::vector<stream_result> stream_results{
+      bench_log_stream<char>("std::ostream", frame_count),
+      bench_log_stream<wchar_t>("std::wostream", frame_count)
+   };
+   print_json(results, stream_results, frame_count);
+   return 0;
+}
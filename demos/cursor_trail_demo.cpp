@@ -118,6 +118,7 @@ auto cursor_trail_demo() -> void
       }
       else {
          for (int halfline = 0; halfline < canvas.get_halfline_height(); ++halfline) {
+            const std::span<oof::color> row = canvas.get_row(halfline);
             for (int column = 0; column < canvas.get_width(); ++column) {
                const s9w::dvec2 cell_pos = s9w::dvec2{ column, halfline } + s9w::dvec2{ 0.5 };
 
@@ -125,9 +126,9 @@ auto cursor_trail_demo() -> void
                const double circle_sdf = s9w::get_length(cell_pos - cursor_cell_pos) - circle_radius;
 
                const s9w::srgb_u effective_brush_color = get_sdf_intensity(circle_sdf) * draw_color;
-               const s9w::srgb_u canvas_color = std::bit_cast<s9w::srgb_u>(canvas.get_color(column, halfline));
+               const s9w::srgb_u canvas_color = std::bit_cast<s9w::srgb_u>(row[column]);
                const s9w::srgb_u result_color = get_max_color(canvas_color, effective_brush_color);
-               canvas.get_color(column, halfline) = std::bit_cast<oof::color>(result_color);
+               row[column] = std::bit_cast<oof::color>(result_color);
             }
          }
          canvas.get_string(string_buffer);
@@ -233,7 +233,8 @@ auto fireworks_demo() -> void
             faded_color.l *= intensity_factor;
             glitter_color = s9w::convert_color<s9w::srgb_u>(faded_color);
          }
-         canvas.get_color(part.m_column, part.m_row) = std::bit_cast<oof::color>(glitter_color);
+         // Glitter is only created inside the canvas
+         canvas.get_color_unchecked(part.m_column, part.m_row) = std::bit_cast<oof::color>(glitter_color);
       }
 
       // Printing, timing; FPS; resizing
@@ -33,13 +33,17 @@ auto radar_demo() -> void
 {
    const int radar_width = 2 * get_screen_cell_dimensions()[1];
    
-   oof::pixel_screen px{ radar_width, radar_width };
+   // Building and printing the string happens on a background thread while the next frame is drawn
+   oof::presenter<oof::pixel_screen> presenter(
+      oof::pixel_screen{ radar_width, radar_width },
+      [](const std::wstring& str) { fast_print(str); }
+   );
+   oof::pixel_screen& px = presenter.get_canvas();
    const s9w::dvec2 center{ radar_width / 2.0 };
    constexpr s9w::dvec2 half_pixel_offset{ 0.5 };
    const double radar_radius = radar_width / 2.0 - 5.0;
 
    timer timer;
-   std::wstring string_buffer;
    double dt{};
    while(true){
       { // Randomly fading pixels to black
@@ -55,17 +59,17 @@ auto radar_demo() -> void
       constexpr double seconds_for_rotation = 2.0;
       const double radar_phi = std::fmod(timer.get_seconds_since_start() * two_pi / seconds_for_rotation, two_pi);
       for(int y=0; y< radar_width; ++y){
+         const std::span<oof::color> row = px.get_row(y);
          for (int x = 0; x < radar_width; ++x){
             const s9w::dvec2 rel_pos = s9w::dvec2{ x, y } - center + half_pixel_offset;
             const double pixel_phi = nonstupid_atan2(rel_pos[1], rel_pos[0]);
             if(s9w::equal(pixel_phi, radar_phi, 0.05) && s9w::get_length(rel_pos) < radar_radius)
-               px.get_color(x, y) = { 255, 0, 0 };
+               row[x] = { 255, 0, 0 };
          }
       }
       
       dt = timer.mark_frame();
-      px.get_string(string_buffer);
-      fast_print(string_buffer);
+      presenter.present();
       if(const auto fps = timer.get_fps(); fps.has_value())
          set_window_title("FPS: " + std::to_string(*fps));
    }
@@ -38,7 +38,7 @@ auto draw_partial_snowflake(
    const uint8_t alpha = get_int<uint8_t>(ratio * 255.0);
    const s9w::srgba_u snow_color{ component, component, component, alpha };
 
-   oof::color& target = px.get_color(column, row);
+   oof::color& target = px.get_color_unchecked(column, row);
    const s9w::srgb_u blend_result = s9w::blend(std::bit_cast<s9w::srgb_u>(target), snow_color);
    target = std::bit_cast<oof::color>(blend_result);
 }
@@ -84,15 +84,13 @@ auto snow_demo() -> void
    while (true) {
       // draw bg
       for(int row=0; row<height; ++row){
-         for (int column = 0; column < width; ++column){
-            const double height_progress = 1.0 * row / (height - 1);
-            const oof::color bg_color{
-               get_int<uint8_t>(30*height_progress),
-               get_int<uint8_t>(30*height_progress),
-               get_int<uint8_t>(100*height_progress)
-            };
-            px.get_color(column, row) = bg_color;
-         }
+         const double height_progress = 1.0 * row / (height - 1);
+         const oof::color bg_color{
+            get_int<uint8_t>(30*height_progress),
+            get_int<uint8_t>(30*height_progress),
+            get_int<uint8_t>(100*height_progress)
+         };
+         std::ranges::fill(px.get_row(row), bg_color);
       }
 
       // draw snow
@@ -87,28 +87,31 @@ namespace
          
          int column = 0;
          int line = 0;
-         for (int i = 0; i < m_string.size(); ++i)
+         std::span<oof::cell<std::string>> line_cells = scr.get_line(line);
+         for (int i = 0; i < m_string.size() && line_cells.empty() == false; ++i)
          {
-            scr.get_cell(column, line).m_letter = m_string[i];
-            const int format_index = std::clamp(drawn_letters - 1 - i, 0, 4);
+            oof::cell<std::string>& target = line_cells[column];
+            target.m_letter = m_string[i];
 
             oof::cell_format format{.m_fg_color = get_letter_color(i, drawn_letters)};
             if (m_bold_states[i] == bold_state::bold) {
                format.m_bold = true;
                format.m_underline = true;
             }
-            scr.get_cell(column, line).m_format = format;
+            target.m_format = format;
 
             ++column;
             if(column == scr.get_width())
             {
                column = 0;
                ++line;
+               line_cells = scr.get_line(line);
             }
             if(std::find(std::cbegin(m_newline_pos), std::cend(m_newline_pos), i+1) != std::cend(m_newline_pos))
             {
                line += 1;
                column = 2;
+               line_cells = scr.get_line(line);
             }
          }
       }
@@ -0,0 +1,194 @@
+// Differential test of the screen renderer. Random frames are rendered by screen::get_string() and by a naive
+// reference renderer that positions the cursor and sets every attribute for every cell. Both outputs go through a
+// terminal emulator and the resulting terminal images must be identical.
+//
+// Built with OOF_LIBFUZZER, this is a libFuzzer target. Otherwise it's a standalone program that runs random inputs:
+//    renderer_fuzzer [iteration_count] [seed]
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#define OOF_IMPL
+#include "../oof.h"
+#include "../tests/vt_emulator.h"
+
+
+namespace {
+
+   // Reads values from the fuzzer input. Runs out gracefully by returning zeros
+   struct input_reader {
+      const uint8_t* m_data = nullptr;
+      size_t m_size = 0;
+      size_t m_pos = 0;
+
+      [[nodiscard]] auto is_empty() const -> bool {
+         return m_pos >= m_size;
+      }
+
+      // In [0, count)
+      [[nodiscard]] auto get(const int count) -> int {
+         if (this->is_empty())
+            return 0;
+         return m_data[m_pos++] % count;
+      }
+   };
+
+
+   template<oof::std_string_type string_type>
+   auto get_reference_string(const oof::screen<string_type>& scr, const int origin_column, const int origin_line) -> string_type
+   {
+      string_type result;
+      int i = 0;
+      for (const oof::cell<string_type>& cell : scr)
+      {
+         const int column = origin_column + i % scr.get_width();
+         const int line = origin_line + i / scr.get_width();
+         ++i;
+         oof::write_sequence_into_string(result, oof::position(line, column));
+         oof::write_sequence_into_string(result, oof::fg_color(cell.m_format.m_fg_color));
+         oof::write_sequence_into_string(result, oof::bg_color(cell.m_format.m_bg_color));
+         oof::write_sequence_into_string(result, oof::underline(cell.m_format.m_underline));
+         oof::write_sequence_into_string(result, oof::bold(cell.m_format.m_bold));
+         result += cell.m_letter;
+      }
+      return result;
+   }
+
+
+   template<oof::std_string_type string_type>
+   auto are_equal(const oof::testing::vt_emulator<string_type>& a, const oof::testing::vt_emulator<string_type>& b) -> bool
+   {
+      for (int line = 0; line < a.get_height(); ++line)
+      {
+         for (int column = 0; column < a.get_width(); ++column)
+         {
+            if (a.get_cell(column, line) != b.get_cell(column, line))
+            {
+               std::fprintf(stderr, "Terminal images differ at column %d, line %d\n", column, line);
+               return false;
+            }
+         }
+      }
+      return true;
+   }
+
+
+   // A few colors and letters, so that cells often end up unchanged or with partially equal formats
+   template<oof::std_string_type string_type>
+   auto get_random_cell(input_reader& reader) -> oof::cell<string_type>
+   {
+      constexpr std::array<oof::color, 4> colors{ oof::color{}, oof::color{ 255 }, oof::color{ 255, 0, 0 }, oof::color{ 0, 0, 9 } };
+      oof::cell<string_type> result;
+      result.m_letter = static_cast<typename string_type::value_type>("ab #"[reader.get(4)]);
+      result.m_format.m_fg_color = colors[reader.get(4)];
+      result.m_format.m_bg_color = colors[reader.get(4)];
+      result.m_format.m_underline = reader.get(4) == 0;
+      result.m_format.m_bold = reader.get(4) == 0;
+      return result;
+   }
+
+
+   template<oof::std_string_type string_type>
+   auto run_frames(input_reader& reader) -> bool
+   {
+      const int width = 1 + reader.get(40);
+      const int height = 1 + reader.get(12);
+      const int origin_column = reader.get(5);
+      const int origin_line = reader.get(5);
+      oof::screen<string_type> scr(width, height, origin_column, origin_line, static_cast<typename string_type::value_type>(' '));
+      scr.set_thread_count(1 + reader.get(4));
+      scr.set_synchronized_output(reader.get(2) == 0);
+
+      const int terminal_width = origin_column + width + 2;
+      const int terminal_height = origin_line + height + 2;
+      oof::testing::vt_emulator<string_type> tested(terminal_width, terminal_height);
+      oof::testing::vt_emulator<string_type> reference(terminal_width, terminal_height);
+
+      string_type buffer;
+      while (reader.is_empty() == false)
+      {
+         // Either a few scattered cells, a whole line or the whole screen change
+         const int change_kind = reader.get(8);
+         if (change_kind == 0)
+         {
+            for (oof::cell<string_type>& cell : scr)
+               cell = get_random_cell<string_type>(reader);
+         }
+         else if (change_kind == 1)
+         {
+            const int line = reader.get(height);
+            const oof::cell<string_type> value = get_random_cell<string_type>(reader);
+            for (int column = 0; column < width; ++column)
+               scr.get_cell(column, line) = value;
+         }
+         else
+         {
+            const int change_count = 1 + reader.get(6);
+            for (int i = 0; i < change_count; ++i)
+               scr.get_cell(reader.get(width), reader.get(height)) = get_random_cell<string_type>(reader);
+         }
+
+         scr.get_string(buffer);
+         tested.write(buffer);
+         reference.write(get_reference_string(scr, origin_column, origin_line));
+         if (are_equal(tested, reference) == false)
+            return false;
+         if (tested.get_stats(oof::testing::sequence_kind::unknown).m_count != 0)
+         {
+            std::fprintf(stderr, "Output contains unknown sequences\n");
+            return false;
+         }
+      }
+      return true;
+   }
+
+
+   auto run_input(const uint8_t* data, const size_t size) -> bool
+   {
+      input_reader reader{ data, size };
+      if (reader.get(2) == 0)
+         return run_frames<std::string>(reader);
+      return run_frames<std::wstring>(reader);
+   }
+
+} // namespace {}
+
+
+#ifdef OOF_LIBFUZZER
+
+extern "C" auto LLVMFuzzerTestOneInput(const uint8_t* data, const size_t size) -> int
+{
+   if (run_input(data, size) == false)
+      std::abort();
+   return 0;
+}
+
+#else
+
+auto main(const int argc, char** argv) -> int
+{
+   const int iteration_count = argc > 1 ? std::atoi(argv[1]) : 1000;
+   const unsigned int seed = argc > 2 ? static_cast<unsigned int>(std::atoi(argv[2])) : 0;
+   std::mt19937 rng(seed);
+   std::uniform_int_distribution<int> size_dist(8, 2000);
+   std::uniform_int_distribution<int> byte_dist(0, 255);
+   std::vector<uint8_t> input;
+   for (int iteration = 0; iteration < iteration_count; ++iteration)
+   {
+      input.resize(size_dist(rng));
+      for (uint8_t& value : input)
+         value = static_cast<uint8_t>(byte_dist(rng));
+      if (run_input(input.data(), input.size()) == false)
+      {
+         std::fprintf(stderr, "Failed in iteration %d with seed %u\n", iteration, seed);
+         return 1;
+      }
+   }
+   std::printf("%d iterations passed\n", iteration_count);
+   return 0;
+}
+
+#endif
@@ -1,8 +1,23 @@
 ﻿#pragma once
 
+#include <algorithm>
+#include <array>
+#include <barrier>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <functional>
+#include <iosfwd>
+#include <limits>
+#include <mutex>
 #include <optional>
+#include <ranges>
+#include <span>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -39,49 +54,64 @@ namespace oof
    struct move_left_sequence; struct move_right_sequence; struct move_up_sequence; struct move_down_sequence;
    struct char_sequence; struct wchar_sequence;
    struct reset_sequence; struct clear_screen_sequence;
+   struct begin_sync_sequence; struct end_sync_sequence;
+   struct scroll_region_sequence; struct reset_scroll_region_sequence; struct scroll_up_sequence; struct scroll_down_sequence;
 
    // Sets the foreground RGB color
-   [[nodiscard]] auto fg_color(const color& col) -> fg_rgb_color_sequence;
+   [[nodiscard]] constexpr auto fg_color(const color& col) -> fg_rgb_color_sequence;
 
    // Sets the foreground indexed color. Index must be in [1, 255]. You can define colors with set_index_color().
-   [[nodiscard]] auto fg_color(int index) -> fg_index_color_sequence;
+   [[nodiscard]] constexpr auto fg_color(int index) -> fg_index_color_sequence;
 
    // Sets the background RGB color
-   [[nodiscard]] auto bg_color(const color& col) -> bg_rgb_color_sequence;
+   [[nodiscard]] constexpr auto bg_color(const color& col) -> bg_rgb_color_sequence;
 
    // Sets the background indexed color. Index must be in [1, 255]. You can define colors with set_index_color().
-   [[nodiscard]] auto bg_color(int index) -> bg_index_color_sequence;
+   [[nodiscard]] constexpr auto bg_color(int index) -> bg_index_color_sequence;
 
    // Sets the indexed color. Index must be in [1, 255].
-   [[nodiscard]] auto set_index_color(int index, const color& col) -> set_index_color_sequence;
+   [[nodiscard]] constexpr auto set_index_color(int index, const color& col) -> set_index_color_sequence;
 
    // Sets the underline state of the console
-   [[nodiscard]] auto underline(bool new_value = true) -> underline_sequence;
+   [[nodiscard]] constexpr auto underline(bool new_value = true) -> underline_sequence;
 
    // Sets the bold state of the console. Warning: Bold is not supported by all console, see readme
-   [[nodiscard]] auto bold(bool new_value = true) -> bold_sequence;
+   [[nodiscard]] constexpr auto bold(bool new_value = true) -> bold_sequence;
 
    // Sets cursor visibility state. Recommended to turn off before doing real-time displays
-   [[nodiscard]] auto cursor_visibility(bool new_value) -> cursor_visibility_sequence;
+   [[nodiscard]] constexpr auto cursor_visibility(bool new_value) -> cursor_visibility_sequence;
+
+   // Begins and ends a synchronized update (DEC mode 2026). The terminal holds back drawing in between, which avoids
+   // tearing. Terminals without support ignore these
+   [[nodiscard]] constexpr auto begin_sync() -> begin_sync_sequence;
+   [[nodiscard]] constexpr auto end_sync() -> end_sync_sequence;
+
+   // Limits scrolling to the lines from top_line to bottom_line, including both. Zero-based. Also moves the cursor home
+   [[nodiscard]] constexpr auto scroll_region(int top_line, int bottom_line) -> scroll_region_sequence;
+   [[nodiscard]] constexpr auto reset_scroll_region() -> reset_scroll_region_sequence;
+
+   // Scrolls the content of the scroll region. Lines that scroll in are empty
+   [[nodiscard]] constexpr auto scroll_up(int amount) -> scroll_up_sequence;
+   [[nodiscard]] constexpr auto scroll_down(int amount) -> scroll_down_sequence;
 
    // Resets foreground- and background color, underline and bold state
-   [[nodiscard]] auto reset_formatting() -> reset_sequence;
+   [[nodiscard]] constexpr auto reset_formatting() -> reset_sequence;
 
    // Clears the screen
-   [[nodiscard]] auto clear_screen() -> clear_screen_sequence;
+   [[nodiscard]] constexpr auto clear_screen() -> clear_screen_sequence;
 
    // Sets the cursor position. Zero-based
-   [[nodiscard]] auto position(int line, int column) -> position_sequence;
-   [[nodiscard]] auto vposition(int line) -> vposition_sequence;
-   [[nodiscard]] auto hposition(int column) -> hposition_sequence;
-   [[nodiscard]] auto store_position() -> store_position_sequence;
-   [[nodiscard]] auto load_position() -> load_position_sequence;
+   [[nodiscard]] constexpr auto position(int line, int column) -> position_sequence;
+   [[nodiscard]] constexpr auto vposition(int line) -> vposition_sequence;
+   [[nodiscard]] constexpr auto hposition(int column) -> hposition_sequence;
+   [[nodiscard]] constexpr auto store_position() -> store_position_sequence;
+   [[nodiscard]] constexpr auto load_position() -> load_position_sequence;
 
    // Moves the cursor a certain amount
-   [[nodiscard]] auto move_left(int amount) -> move_left_sequence;
-   [[nodiscard]] auto move_right(int amount) -> move_right_sequence;
-   [[nodiscard]] auto move_up(int amount) -> move_up_sequence;
-   [[nodiscard]] auto move_down(int amount) -> move_down_sequence;
+   [[nodiscard]] constexpr auto move_left(int amount) -> move_left_sequence;
+   [[nodiscard]] constexpr auto move_right(int amount) -> move_right_sequence;
+   [[nodiscard]] constexpr auto move_up(int amount) -> move_up_sequence;
+   [[nodiscard]] constexpr auto move_down(int amount) -> move_down_sequence;
 
 
    using error_callback_type = void(*)(const std::string& msg);
@@ -104,7 +134,9 @@ namespace oof
       fg_rgb_color_sequence, fg_index_color_sequence, bg_index_color_sequence, bg_rgb_color_sequence, set_index_color_sequence,
       position_sequence, hposition_sequence, vposition_sequence, store_position_sequence, load_position_sequence,
       underline_sequence, bold_sequence, char_sequence, wchar_sequence, reset_sequence, clear_screen_sequence, cursor_visibility_sequence,
-      move_left_sequence, move_right_sequence, move_up_sequence, move_down_sequence
+      move_left_sequence, move_right_sequence, move_up_sequence, move_down_sequence,
+      begin_sync_sequence, end_sync_sequence,
+      scroll_region_sequence, reset_scroll_region_sequence, scroll_up_sequence, scroll_down_sequence
    >;
 
    template<typename T>
@@ -146,6 +178,48 @@ namespace oof
    };
 
 
+   template<oof::std_string_type string_type> struct viewport;
+
+   namespace detail {
+      template<typename T> struct raster_view;
+
+      // Horizontal run of opaque pixels in a sprite or glyph
+      struct pixel_run {
+         int m_row = 0;
+         int m_column = 0;
+         int m_length = 0;
+      };
+   }
+
+
+   // A rectangle of cells that gets sent first when rendering with a byte budget. Higher priority goes first
+   struct priority_region {
+      int m_column = 0;
+      int m_line = 0;
+      int m_width = 0;
+      int m_height = 0;
+      int m_priority = 0;
+   };
+
+
+   // Counters of the last frame. Only collected if OOF_RENDER_STATS is defined before including oof.h, otherwise none
+   // of this costs anything
+   struct render_stats {
+      int m_cells_scanned = 0;
+      int m_cells_changed = 0;
+      int m_cursor_jumps = 0; // Position and move sequences
+      int m_fg_color_sequences = 0;
+      int m_bg_color_sequences = 0;
+      int m_underline_sequences = 0;
+      int m_bold_sequences = 0;
+      int m_reset_sequences = 0;
+      size_t m_output_size = 0; // In characters of the string type
+      int m_reallocations = 0; // Of the output string and the sequence buffer
+      std::chrono::nanoseconds m_diff_time{};
+      std::chrono::nanoseconds m_serialization_time{};
+   };
+
+
    template<oof::std_string_type string_type>
    struct screen{
       using char_type = typename string_type::value_type;
@@ -163,22 +237,86 @@ namespace oof
       
       [[nodiscard]] auto get_cell (int column, int line) -> cell<string_type>&;
       [[nodiscard]] auto is_inside(int column, int line) const -> bool;
+
+      // All cells of one line, for row-major loops without index math per cell. Empty if the line is out of range
+      [[nodiscard]] auto get_line(int line) const -> std::span<const cell<string_type>>;
+      [[nodiscard]] auto get_line(int line)       -> std::span<cell<string_type>>;
+
       [[nodiscard]] auto get_string(                   ) const -> string_type;
                     auto get_string(string_type& buffer) const -> void;
 
+      // Limits the output to byte_budget characters. Changed cells are sent in the order of their priority and color
+      // error, the rest is carried over into the next call
+                    auto get_string(string_type& buffer, size_t byte_budget) const -> void;
+
+      // Only diffs and writes the cells inside the rectangle. Everything outside of it stays pending for later calls
+                    auto get_string(string_type& buffer, int column, int line, int width, int height) const -> void;
+
+      // Cells inside prioritized regions are sent first when rendering with a byte budget
+      auto set_priority(int column, int line, int width, int height, int priority) -> void;
+      auto clear_priorities() -> void;
+
+      // Wraps every frame in begin_sync() and end_sync() sequences. Off by default
+      auto set_synchronized_output(bool new_value) -> void;
+
+      // Splits diffing and string building into horizontal bands that are processed in parallel. The output is
+      // identical to the single-threaded one. Only worth it for very big screens. Default is 1
+      auto set_thread_count(int thread_count) -> void;
+
+      // The sequences of the last single-threaded get_string() call
+      [[nodiscard]] auto get_sequences() const -> const std::vector<sequence_variant_type>&;
+
+#ifdef OOF_RENDER_STATS
+      // Of the last single-threaded get_string() call
+      [[nodiscard]] auto get_render_stats() const -> const render_stats&;
+#endif
+
       // This writes a text into the screen cells
       auto write_into(const string_type& text, int column, int line, const cell_format& formatting) -> void;
 
       // Override all cells with the background state
       auto clear() -> void;
 
+      // Drawing primitives. They set whole cells and are clipped to the screen
+      auto draw_hline (int column, int line, int length, const cell<string_type>& value) -> void;
+      auto draw_vline (int column, int line, int length, const cell<string_type>& value) -> void;
+      auto fill_rect  (int column, int line, int width, int height, const cell<string_type>& value) -> void;
+      auto draw_rect  (int column, int line, int width, int height, const cell<string_type>& value) -> void;
+      auto draw_line  (int column0, int line0, int column1, int line1, const cell<string_type>& value) -> void;
+      auto draw_circle(int center_column, int center_line, int radius, const cell<string_type>& value) -> void;
+      auto fill_circle(int center_column, int center_line, int radius, const cell<string_type>& value) -> void;
+
+      // Copies a row-major block of cells with the given width into the screen
+      auto blit(int column, int line, std::span<const cell<string_type>> source, int source_width) -> void;
+
       [[nodiscard]] auto begin() const { return std::begin(m_cells); }
       [[nodiscard]] auto begin()       { return std::begin(m_cells); }
       [[nodiscard]] auto end()   const { return std::end(m_cells); }
       [[nodiscard]] auto end()         { return std::end(m_cells); }
 
    private:
+      friend struct viewport<string_type>;
+
+      [[nodiscard]] auto get_raster_view() -> detail::raster_view<cell<string_type>>;
+      auto shift_old_lines(int amount) const -> void;
       auto update_sequence_buffer() const -> void;
+      auto update_sequence_buffer(const std::vector<int>& cell_indices) const -> void;
+      auto update_sequence_buffer(int first_column, int end_column, int first_line, int end_line) const -> void;
+      auto initialize_old_cells() const -> void;
+      [[nodiscard]] auto get_priority(int cell_index) const -> int;
+      auto write_string_parallel(string_type& buffer) const -> void;
+
+      struct band {
+         std::vector<sequence_variant_type> m_sequences;
+         string_type m_string;
+         std::optional<int> m_last_changed_index;
+      };
+
+      struct budget_candidate {
+         int m_index;
+         int m_priority;
+         int m_error;
+      };
 
       int m_width = 0;
       int m_height = 0;
@@ -188,14 +326,195 @@ namespace oof
       std::vector<cell<string_type>> m_cells;
       mutable std::vector<cell<string_type>> m_old_cells;
       mutable std::vector<sequence_variant_type> m_sequence_buffer;
+      std::vector<priority_region> m_priority_regions;
+      bool m_synchronized_output = false;
+      int m_thread_count = 1;
+      mutable std::vector<band> m_bands;
+      mutable std::vector<budget_candidate> m_budget_candidates; // Kept between calls so that budgeted frames don't allocate
+      mutable std::vector<int> m_budget_selection;
+#ifdef OOF_RENDER_STATS
+      mutable render_stats m_render_stats;
+#endif
+   };
+
+
+   // Screen with a size that's known at compile time, for fixed-size widgets like status bars. The cells live inside
+   // the object and the sequence buffer is reserved for the worst case on construction, so rendering never allocates
+   // besides growing the output string. The output is the same as from a screen of the same size. Use get_cells() to
+   // blit it into a screen or a compositor layer.
+   template<int width, int height, oof::std_string_type string_type>
+   struct static_screen {
+      static_assert(width > 0 && height > 0, "static_screen needs a positive size");
+      using char_type = typename string_type::value_type;
+      static constexpr int cell_count = width * height;
+
+      explicit static_screen(int start_column, int start_line, const cell<string_type>& background);
+
+      // This constructor taking a fill_char implies black background, white foreground color
+      explicit static_screen(int start_column, int start_line, char_type fill_char);
+
+      // This constructor taking a fill_char implies black background, white foreground color and top left start
+      explicit static_screen(char_type fill_char);
+
+      [[nodiscard]] static constexpr auto get_width() -> int { return width; }
+      [[nodiscard]] static constexpr auto get_height() -> int { return height; }
+
+      [[nodiscard]] auto get_cell (int column, int line) -> cell<string_type>&;
+      [[nodiscard]] auto is_inside(int column, int line) const -> bool;
+      [[nodiscard]] auto get_cells() const -> std::span<const cell<string_type>, cell_count>;
+
+      // All cells of one line. Empty if the line is out of range
+      [[nodiscard]] auto get_line(int line) const -> std::span<const cell<string_type>>;
+      [[nodiscard]] auto get_line(int line)       -> std::span<cell<string_type>>;
+      [[nodiscard]] auto get_string(                   ) const -> string_type;
+                    auto get_string(string_type& buffer) const -> void;
+
+      // Wraps every frame in begin_sync() and end_sync() sequences. Off by default
+      auto set_synchronized_output(bool new_value) -> void;
+
+      // The sequences of the last get_string() call
+      [[nodiscard]] auto get_sequences() const -> const std::vector<sequence_variant_type>&;
+
+      // This writes a text into the screen cells
+      auto write_into(const string_type& text, int column, int line, const cell_format& formatting) -> void;
+
+      // Override all cells with the background state
+      auto clear() -> void;
+
+      [[nodiscard]] auto begin() const { return std::begin(m_cells); }
+      [[nodiscard]] auto begin()       { return std::begin(m_cells); }
+      [[nodiscard]] auto end()   const { return std::end(m_cells); }
+      [[nodiscard]] auto end()         { return std::end(m_cells); }
+
+   private:
+      auto update_sequence_buffer() const -> void;
+
+      int m_origin_line = 0;
+      int m_origin_column = 0;
+      cell<string_type> m_background;
+      std::array<cell<string_type>, cell_count> m_cells;
+      mutable std::array<cell<string_type>, cell_count> m_old_cells;
+      mutable bool m_has_old_cells = false;
+      mutable std::vector<sequence_variant_type> m_sequence_buffer;
+      bool m_synchronized_output = false;
    };
    
 
+   // Window onto a canvas that's bigger than the terminal. Only the cells in the window that differ from what's displayed
+   // are written. Vertical panning can also use terminal scrolling, see set_terminal_scrolling()
+   template<oof::std_string_type string_type>
+   struct viewport {
+      explicit viewport(
+         int canvas_width, int canvas_height,
+         int view_width, int view_height,
+         int start_column, int start_line,
+         const cell<string_type>& background
+      );
+
+      // The whole content. It has all the drawing functions of a screen, its position is ignored
+      [[nodiscard]] auto get_canvas() -> screen<string_type>&;
+
+      // Top left corner of the window inside the canvas. Gets clamped so the window stays inside
+      auto set_offset(int column, int line) -> void;
+      [[nodiscard]] auto get_offset_column() const -> int;
+      [[nodiscard]] auto get_offset_line() const -> int;
+
+      [[nodiscard]] auto get_view_width() const -> int;
+      [[nodiscard]] auto get_view_height() const -> int;
+
+      [[nodiscard]] auto get_string(                   ) const -> string_type;
+                    auto get_string(string_type& buffer) const -> void;
+
+      // Pans vertically by scrolling the terminal and then only draws the lines that scrolled in. Scrolling affects
+      // whole terminal lines, so only turn this on if the window spans the whole width of the terminal. Off by default
+      auto set_terminal_scrolling(bool new_value) -> void;
+
+      // Wraps every frame in begin_sync() and end_sync() sequences. Off by default
+      auto set_synchronized_output(bool new_value) -> void;
+
+   private:
+      auto update_view() const -> void;
+
+      screen<string_type> m_canvas;
+      int m_offset_column = 0;
+      int m_offset_line = 0;
+      bool m_terminal_scrolling = false;
+      bool m_synchronized_output = false;
+      mutable screen<string_type> m_view;
+      mutable std::optional<int> m_displayed_offset_line;
+      mutable std::vector<sequence_variant_type> m_sequence_buffer;
+      mutable string_type m_frame_buffer;
+   };
+
+
+   // How many pixels a pixel_screen puts into one cell
+   enum class pixel_mode {
+      half_block, // 1x2, with '▀'
+      quadrant,   // 2x2, with quadrant block elements like '▚'
+      sextant     // 2x3, with the sextant characters from Unicode 13. Needs a font that has them and 32 bit wchar_t
+   };
+
+
+   // Image for drawing into a pixel_screen over and over. The opaque parts are stored as runs, so drawing is one copy
+   // per run instead of a check per pixel.
+   struct sprite {
+      // Completely opaque sprite. pixels is row-major with width * height colors
+      explicit sprite(int width, int height, const std::vector<color>& pixels);
+
+      // Pixels with a zero in the alpha mask are transparent
+      explicit sprite(int width, int height, const std::vector<color>& pixels, const std::vector<uint8_t>& alpha_mask);
+
+      [[nodiscard]] auto get_width() const -> int;
+      [[nodiscard]] auto get_height() const -> int;
+
+   private:
+      friend struct pixel_screen;
+
+      int m_width = 0;
+      int m_height = 0;
+      std::vector<color> m_pixels;
+      std::vector<detail::pixel_run> m_runs;
+   };
+
+
+   // Monochrome font with glyphs of a fixed size, for text that's drawn as pixels
+   struct bitmap_font {
+      explicit bitmap_font(int glyph_width, int glyph_height);
+
+      // The mask is row-major with glyph_width * glyph_height entries. Nonzero entries are set
+      auto set_glyph(wchar_t letter, const std::vector<uint8_t>& mask) -> void;
+      [[nodiscard]] auto has_glyph(wchar_t letter) const -> bool;
+      [[nodiscard]] auto get_glyph_width() const -> int;
+      [[nodiscard]] auto get_glyph_height() const -> int;
+
+   private:
+      friend struct pixel_screen;
+
+      struct glyph {
+         wchar_t m_letter{};
+         std::vector<detail::pixel_run> m_runs;
+      };
+
+      [[nodiscard]] auto find_glyph(wchar_t letter) const -> const glyph*;
+
+      int m_glyph_width = 0;
+      int m_glyph_height = 0;
+      std::vector<glyph> m_glyphs; // Sorted by letter
+   };
+
+   // A 3x5 font with digits, upper case letters (also used for lower case) and some punctuation
+   [[nodiscard]] auto get_default_font() -> const bitmap_font&;
+
+
    struct pixel_screen {
       std::vector<color> m_pixels;
 
       explicit pixel_screen(int width, int halfline_height, int start_column, int start_halfline, const color& fill_color);
 
+      // In the quadrant and sextant modes, cells show the best two-color approximation of their pixels. All sizes and
+      // positions are in pixels, so a "halfline" is a pixel row and a column a pixel column.
+      explicit pixel_screen(int width, int halfline_height, int start_column, int start_halfline, const color& fill_color, pixel_mode mode);
+
       // This will init with black fill color
       explicit pixel_screen(int width, int halfline_height, int start_column, int start_halfline);
 
@@ -209,30 +528,271 @@ namespace oof
       
       [[nodiscard]] auto get_string(                    ) const -> std::wstring;
                     auto get_string(std::wstring& buffer) const -> void;
+                    auto get_string(std::wstring& buffer, size_t byte_budget) const -> void;
       [[nodiscard]] auto get_width() const -> int;
       [[nodiscard]] auto get_halfline_height() const -> int;
 
-      // If you want to override something in the screen
+      // If you want to override something in the screen. By default, the output is built directly from the pixels.
+      // Once this is called, the pixels go through this screen instead, which costs more time and memory.
       [[nodiscard]] auto get_screen_ref() -> screen<std::wstring>&;
 
+      // Wraps every frame in begin_sync() and end_sync() sequences. Off by default
+      auto set_synchronized_output(bool new_value) -> void;
+
+      // The sequences of the last get_string() call
+      [[nodiscard]] auto get_sequences() const -> const std::vector<sequence_variant_type>&;
+
+#ifdef OOF_RENDER_STATS
+      // Of the last get_string() call
+      [[nodiscard]] auto get_render_stats() const -> const render_stats&;
+#endif
+
       // Override all pixels with the fill color
                     auto clear() -> void;
       
+      // Out of range coordinates are reported to the error callback
       [[nodiscard]] auto get_color(int column, int halfline) const -> const color&;
       [[nodiscard]] auto get_color(int column, int halfline)       -> color&;
       [[nodiscard]] auto is_in    (int column, int halfline) const -> bool;
 
+      // No checks at all. For hot loops that already know their coordinates are inside
+      [[nodiscard]] auto get_color_unchecked(int column, int halfline) const -> const color&;
+      [[nodiscard]] auto get_color_unchecked(int column, int halfline)       -> color&;
+
+      // All pixels of one halfline. Empty if the halfline is out of range
+      [[nodiscard]] auto get_row(int halfline) const -> std::span<const color>;
+      [[nodiscard]] auto get_row(int halfline)       -> std::span<color>;
+
+      // Drawing primitives. They're clipped to the screen
+      auto draw_hline (int column, int halfline, int length, const color& col) -> void;
+      auto draw_vline (int column, int halfline, int length, const color& col) -> void;
+      auto fill_rect  (int column, int halfline, int width, int height, const color& col) -> void;
+      auto draw_rect  (int column, int halfline, int width, int height, const color& col) -> void;
+      auto draw_line  (int column0, int halfline0, int column1, int halfline1, const color& col) -> void;
+      auto draw_circle(int center_column, int center_halfline, int radius, const color& col) -> void;
+      auto fill_circle(int center_column, int center_halfline, int radius, const color& col) -> void;
+
+      // Mixes the color into the rectangle. An alpha of 255 is the same as fill_rect()
+      auto blend_rect(int column, int halfline, int width, int height, const color& col, uint8_t alpha) -> void;
+
+      // Copies a row-major block of colors with the given width into the screen
+      auto blit(int column, int halfline, std::span<const color> source, int source_width) -> void;
+
+      // Draws the opaque pixels of the sprite with its top left corner at the position
+      auto draw_sprite(const sprite& source, int column, int halfline) -> void;
+
+      // Draws text with its top left corner at the position. Every glyph pixel becomes a square of scale pixels.
+      // Letters without glyphs are skipped, and '\n' starts a new line of text
+      auto draw_text(const bitmap_font& font, const std::wstring& text, int column, int halfline, const color& col, int scale = 1) -> void;
+
    private:
+      [[nodiscard]] auto get_raster_view() -> detail::raster_view<color>;
       [[nodiscard]] auto get_line_height() const -> int;
+      [[nodiscard]] auto get_cell_width() const -> int;
+      [[nodiscard]] auto get_checked_index(int column, int halfline) const -> size_t;
+      [[nodiscard]] auto get_subpixel_width() const -> int;
+      [[nodiscard]] auto get_subpixel_height() const -> int;
+      [[nodiscard]] auto get_row_or_fill(const std::vector<color>& pixels, int halfline) const -> const color*;
+      auto gather_subpixels(const std::vector<color>& pixels, int line, int cell_column, color* target) const -> void;
+      [[nodiscard]] auto get_subcell(const color* subpixels) const -> cell<std::wstring>;
+      [[nodiscard]] auto get_or_create_screen() const -> screen<std::wstring>&;
       auto compute_result() const -> void;
+      auto update_sequence_buffer() const -> void;
 
       color m_fill_color{};
+      pixel_mode m_mode = pixel_mode::half_block;
+      int m_width = 0;
       int m_halfline_height = 0; // This refers to "pixel" height. Height in lines will be half that.
       int m_origin_column = 0;
       int m_origin_halfline = 0;
-      mutable screen<std::wstring> m_screen;
+      bool m_synchronized_output = false;
+      std::vector<color> m_fill_row; // Stands in for pixel rows above and below the screen
+      mutable std::vector<color> m_old_pixels;
+      mutable std::vector<sequence_variant_type> m_sequence_buffer;
+      mutable std::optional<screen<std::wstring>> m_screen;
+#ifdef OOF_RENDER_STATS
+      mutable render_stats m_render_stats;
+#endif
+   };
+
+
+   // Monochrome canvas with 2x4 dots per cell, drawn with Braille characters. Every cell has one color for its dots.
+   // Dots are in the dot coordinates, colors and sizes in cells.
+   struct braille_screen {
+      explicit braille_screen(int width, int height, int start_column, int start_line, const color& dot_color, const color& bg_color);
+
+      // This will init with white dots on black background
+      explicit braille_screen(int width, int height, int start_column, int start_line);
+
+      // This will init with white dots on black background and starting at the top left
+      explicit braille_screen(int width, int height);
+
+      [[nodiscard]] auto get_string(                    ) const -> std::wstring;
+                    auto get_string(std::wstring& buffer) const -> void;
+      [[nodiscard]] auto get_width() const -> int;
+      [[nodiscard]] auto get_height() const -> int;
+      [[nodiscard]] auto get_dot_width() const -> int;
+      [[nodiscard]] auto get_dot_height() const -> int;
+
+      // Dots outside of the screen are ignored
+                    auto set_dot  (int x, int y) -> void;
+                    auto set_dot  (int x, int y, const color& col) -> void;
+                    auto clear_dot(int x, int y) -> void;
+      [[nodiscard]] auto is_dot_set(int x, int y) const -> bool;
+      [[nodiscard]] auto is_dot_in (int x, int y) const -> bool;
+
+      [[nodiscard]] auto get_color(int column, int line) const -> const color&;
+      [[nodiscard]] auto get_color(int column, int line)       -> color&;
+
+      // Wraps every frame in begin_sync() and end_sync() sequences. Off by default
+      auto set_synchronized_output(bool new_value) -> void;
+
+      // Removes all dots and resets the colors
+      auto clear() -> void;
+
+   private:
+      auto update_sequence_buffer() const -> void;
+
+      int m_width = 0;
+      int m_height = 0;
+      int m_origin_column = 0;
+      int m_origin_line = 0;
+      color m_dot_color{};
+      color m_bg_color{};
+      bool m_synchronized_output = false;
+      std::vector<uint8_t> m_dots; // One byte of dots per cell, in the bit order of the Braille block
+      std::vector<color> m_colors;
+      mutable std::vector<uint8_t> m_old_dots;
+      mutable std::vector<color> m_old_colors;
+      mutable std::vector<sequence_variant_type> m_sequence_buffer;
+   };
+
+
+   // Stacks several layers into one output screen, so that overlapping regions are only written once. Layers are
+   // screens with a position relative to the compositor. Cells with a letter of char_type{} are transparent, and new
+   // layers start out completely transparent. Only the regions of layers that changed get composited again.
+   template<oof::std_string_type string_type>
+   struct compositor {
+      using char_type = typename string_type::value_type;
+
+      explicit compositor(int width, int height, int start_column, int start_line, const cell<string_type>& background);
+
+      // Returns the id of the new layer. Layers with a higher z_order are drawn on top, equal ones in order of creation
+      auto add_layer(int column, int line, int width, int height, int z_order) -> int;
+
+      // Marks the whole layer as changed
+      [[nodiscard]] auto get_layer(int layer_id) -> screen<string_type>&;
+
+      auto set_layer_position(int layer_id, int column, int line) -> void;
+      auto set_layer_visible (int layer_id, bool visible) -> void;
+      auto set_layer_z_order (int layer_id, int z_order) -> void;
+
+      // Layers with an opacity below 255 are blended over the colors below them
+      auto set_layer_opacity (int layer_id, uint8_t opacity) -> void;
+
+      [[nodiscard]] auto get_width() const -> int;
+      [[nodiscard]] auto get_height() const -> int;
+      [[nodiscard]] auto get_string(                   ) const -> string_type;
+                    auto get_string(string_type& buffer) const -> void;
+
+      // Wraps every frame in begin_sync() and end_sync() sequences. Off by default
+      auto set_synchronized_output(bool new_value) -> void;
+
+   private:
+      struct region {
+         int m_column = 0;
+         int m_line = 0;
+         int m_width = 0;
+         int m_height = 0;
+      };
+
+      struct layer {
+         screen<string_type> m_screen;
+         int m_column = 0;
+         int m_line = 0;
+         int m_z_order = 0;
+         uint8_t m_opacity = 255;
+         bool m_visible = true;
+         mutable bool m_dirty = true;
+      };
+
+      [[nodiscard]] auto get_checked_layer(int layer_id) -> layer&;
+      [[nodiscard]] auto get_region(const layer& target) const -> region;
+      auto update_draw_order() -> void;
+      auto composite() const -> void;
+      auto composite_region(const region& target_region) const -> void;
+
+      int m_width = 0;
+      int m_height = 0;
+      cell<string_type> m_background;
+      std::vector<layer> m_layers;
+      std::vector<int> m_draw_order; // Layer ids from bottom to top
+      mutable std::vector<region> m_dirty_regions; // Regions that need to be composited, besides the dirty layers
+      mutable screen<string_type> m_output;
+   };
+
+
+   // What present() does when all frame buffers are waiting to be written
+   enum class present_policy {
+      block,     // Waits until the output thread takes a frame
+      drop_frame // Replaces the oldest waiting frame
+   };
+
+   struct presenter_stats {
+      std::chrono::nanoseconds m_last_latency{}; // From the start of get_string() to the end of the write
+      std::chrono::nanoseconds m_max_latency{};
+      int m_written_frames = 0;
+      int m_dropped_frames = 0;
    };
 
+   // Pipelines drawing and output: While the app draws the next frame into get_canvas(), a background thread builds
+   // the string of the previous one and hands it to the write callback. canvas_type is a screen or a pixel_screen.
+   template<typename canvas_type>
+   struct presenter {
+      using string_type = std::remove_cvref_t<decltype(std::declval<const canvas_type&>().get_string())>;
+      using write_callback_type = std::function<void(const string_type&)>;
+
+      // buffer_count is the number of frames including the one that's being drawn. Must be at least 2
+      explicit presenter(
+         const canvas_type& canvas,
+         write_callback_type write_callback,
+         int buffer_count = 2,
+         present_policy policy = present_policy::block
+      );
+      ~presenter();
+      presenter(const presenter&) = delete;
+      presenter& operator=(const presenter&) = delete;
+
+      // The canvas to draw into. It keeps its content after present()
+      [[nodiscard]] auto get_canvas() -> canvas_type&;
+
+      // Hands a copy of the canvas to the output thread
+      auto present() -> void;
+
+      // Blocks until all presented frames are written
+      auto wait_until_written() -> void;
+
+      [[nodiscard]] auto get_stats() const -> presenter_stats;
+
+   private:
+      using element_type = std::ranges::range_value_t<canvas_type>;
+      auto output_loop() -> void;
+
+      canvas_type m_canvas;
+      canvas_type m_output_canvas;
+      write_callback_type m_write_callback;
+      size_t m_max_waiting_frames = 1;
+      present_policy m_policy = present_policy::block;
+
+      mutable std::mutex m_mutex;
+      std::condition_variable m_condition;
+      std::deque<std::vector<element_type>> m_waiting_frames;
+      std::vector<std::vector<element_type>> m_free_frames;
+      bool m_is_writing = false;
+      bool m_stop = false;
+      presenter_stats m_stats;
+      std::jthread m_output_thread;
+   };
 
 
    // Deduction guide
@@ -259,7 +819,351 @@ namespace oof
 
       auto error(const std::string& msg) -> void;
 
-      [[nodiscard]] auto get_pixel_background(const color& fill_color) -> cell<std::wstring>;
+      [[nodiscard]] auto get_pixel_background(const color& fill_color, pixel_mode mode) -> cell<std::wstring>;
+
+      // Two-color approximation of the pixels of a cell. Bit i of the mask is set if pixel i gets the foreground color.
+      // Pixels are in row-major order.
+      struct subcell_fit {
+         int m_mask = 0;
+         color m_fg_color;
+         color m_bg_color;
+      };
+      [[nodiscard]] auto get_subcell_fit(const color* subpixels, int count) -> subcell_fit;
+      [[nodiscard]] auto get_subcell_letter(pixel_mode mode, int mask) -> wchar_t;
+
+      // Row-major block of values that the drawing primitives work on. All functions clip to it
+      template<typename T>
+      struct raster_view {
+         T* m_data = nullptr;
+         int m_width = 0;
+         int m_height = 0;
+
+         [[nodiscard]] constexpr auto is_inside(const int column, const int row) const -> bool {
+            return column >= 0 && column < m_width && row >= 0 && row < m_height;
+         }
+      };
+
+      template<typename T>
+      auto fill_rect(const raster_view<T>& view, int column, int row, int width, int height, const T& value) -> void;
+      template<typename T>
+      auto draw_rect(const raster_view<T>& view, int column, int row, int width, int height, const T& value) -> void;
+      template<typename T>
+      auto draw_line(const raster_view<T>& view, int column0, int row0, int column1, int row1, const T& value) -> void;
+      template<typename T>
+      auto draw_circle(const raster_view<T>& view, int center_column, int center_row, int radius, const T& value) -> void;
+      template<typename T>
+      auto fill_circle(const raster_view<T>& view, int center_column, int center_row, int radius, const T& value) -> void;
+      template<typename T>
+      auto blit(const raster_view<T>& view, int column, int row, std::span<const T> source, int source_width) -> void;
+      auto blend_rect(const raster_view<color>& view, int column, int row, int width, int height, const color& col, uint8_t alpha) -> void;
+      [[nodiscard]] auto get_blended(const color& background, const color& foreground, uint8_t alpha) -> color;
+
+      // Runs of the nonzero entries in a row-major mask
+      [[nodiscard]] auto get_pixel_runs(int width, int height, const std::vector<uint8_t>& mask) -> std::vector<pixel_run>;
+
+#ifdef OOF_RENDER_STATS
+      // Fills the render_stats of one frame. Created before the diff, end_diff() after it and finish() at the end
+      struct stats_recorder {
+         using clock_type = std::chrono::steady_clock;
+
+         render_stats& m_stats;
+         size_t m_buffer_capacity = 0;
+         size_t m_sequence_capacity = 0;
+         clock_type::time_point m_start = clock_type::now();
+         clock_type::time_point m_diff_end{};
+
+         auto end_diff() -> void;
+         auto finish(
+            const std::vector<sequence_variant_type>& sequences,
+            int cells_scanned,
+            size_t output_size,
+            size_t buffer_capacity
+         ) -> void;
+      };
+#endif
+
+      // Rows of the default font glyphs, '#' is set
+      constexpr std::array<std::pair<char, const char*>, 50> default_font_glyphs{ {
+         {'0', "###"
+               "#.#"
+               "#.#"
+               "#.#"
+               "###"},
+         {'1', ".#."
+               "##."
+               ".#."
+               ".#."
+               "###"},
+         {'2', "###"
+               "..#"
+               "###"
+               "#.."
+               "###"},
+         {'3', "###"
+               "..#"
+               "###"
+               "..#"
+               "###"},
+         {'4', "#.#"
+               "#.#"
+               "###"
+               "..#"
+               "..#"},
+         {'5', "###"
+               "#.."
+               "###"
+               "..#"
+               "###"},
+         {'6', "###"
+               "#.."
+               "###"
+               "#.#"
+               "###"},
+         {'7', "###"
+               "..#"
+               "..#"
+               "..#"
+               "..#"},
+         {'8', "###"
+               "#.#"
+               "###"
+               "#.#"
+               "###"},
+         {'9', "###"
+               "#.#"
+               "###"
+               "..#"
+               "###"},
+         {'A', ".#."
+               "#.#"
+               "###"
+               "#.#"
+               "#.#"},
+         {'B', "##."
+               "#.#"
+               "##."
+               "#.#"
+               "##."},
+         {'C', ".##"
+               "#.."
+               "#.."
+               "#.."
+               ".##"},
+         {'D', "##."
+               "#.#"
+               "#.#"
+               "#.#"
+               "##."},
+         {'E', "###"
+               "#.."
+               "##."
+               "#.."
+               "###"},
+         {'F', "###"
+               "#.."
+               "##."
+               "#.."
+               "#.."},
+         {'G', ".##"
+               "#.."
+               "#.#"
+               "#.#"
+               ".##"},
+         {'H', "#.#"
+               "#.#"
+               "###"
+               "#.#"
+               "#.#"},
+         {'I', "###"
+               ".#."
+               ".#."
+               ".#."
+               "###"},
+         {'J', "..#"
+               "..#"
+               "..#"
+               "#.#"
+               ".#."},
+         {'K', "#.#"
+               "#.#"
+               "##."
+               "#.#"
+               "#.#"},
+         {'L', "#.."
+               "#.."
+               "#.."
+               "#.."
+               "###"},
+         {'M', "#.#"
+               "###"
+               "###"
+               "#.#"
+               "#.#"},
+         {'N', "##."
+               "#.#"
+               "#.#"
+               "#.#"
+               "#.#"},
+         {'O', ".#."
+               "#.#"
+               "#.#"
+               "#.#"
+               ".#."},
+         {'P', "##."
+               "#.#"
+               "##."
+               "#.."
+               "#.."},
+         {'Q', ".#."
+               "#.#"
+               "#.#"
+               "##."
+               ".##"},
+         {'R', "##."
+               "#.#"
+               "##."
+               "#.#"
+               "#.#"},
+         {'S', ".##"
+               "#.."
+               ".#."
+               "..#"
+               "##."},
+         {'T', "###"
+               ".#."
+               ".#."
+               ".#."
+               ".#."},
+         {'U', "#.#"
+               "#.#"
+               "#.#"
+               "#.#"
+               "###"},
+         {'V', "#.#"
+               "#.#"
+               "#.#"
+               "#.#"
+               ".#."},
+         {'W', "#.#"
+               "#.#"
+               "###"
+               "###"
+               "#.#"},
+         {'X', "#.#"
+               "#.#"
+               ".#."
+               "#.#"
+               "#.#"},
+         {'Y', "#.#"
+               "#.#"
+               ".#."
+               ".#."
+               ".#."},
+         {'Z', "###"
+               "..#"
+               ".#."
+               "#.."
+               "###"},
+         {' ', "..."
+               "..."
+               "..."
+               "..."
+               "..."},
+         {'.', "..."
+               "..."
+               "..."
+               "..."
+               ".#."},
+         {',', "..."
+               "..."
+               "..."
+               ".#."
+               "#.."},
+         {':', "..."
+               ".#."
+               "..."
+               ".#."
+               "..."},
+         {'-', "..."
+               "..."
+               "###"
+               "..."
+               "..."},
+         {'+', "..."
+               ".#."
+               "###"
+               ".#."
+               "..."},
+         {'=', "..."
+               "###"
+               "..."
+               "###"
+               "..."},
+         {'!', ".#."
+               ".#."
+               ".#."
+               "..."
+               ".#."},
+         {'?', "##."
+               "..#"
+               ".#."
+               "..."
+               ".#."},
+         {'%', "#.#"
+               "..#"
+               ".#."
+               "#.."
+               "#.#"},
+         {'/', "..#"
+               "..#"
+               ".#."
+               "#.."
+               "#.."},
+         {'(', "..#"
+               ".#."
+               ".#."
+               ".#."
+               "..#"},
+         {')', "#.."
+               ".#."
+               ".#."
+               ".#."
+               "#.."},
+         {'\'', ".#."
+               ".#."
+               "..."
+               "..."
+               "..."}
+      } };
+
+      // Bit of a dot inside its Braille cell, indexed with [y % 4][x % 2]
+      constexpr std::array<std::array<uint8_t, 2>, 4> braille_dot_bits{ {
+         { 0x01, 0x08 },
+         { 0x02, 0x10 },
+         { 0x04, 0x20 },
+         { 0x40, 0x80 }
+      } };
+
+      // Writes one line of the pixel_screen from two rows of pixels
+      auto write_pixel_line(
+         cell<std::wstring>* target,
+         const color* top_row,
+         const color* bottom_row,
+         int width
+      ) -> void;
+
+      // Calls fun(i) for i in [0, count) with each call on its own thread. The calling thread takes i=0
+      template<typename fun_type>
+      auto run_parallel(int count, const fun_type& fun) -> void;
+
+      // Sum of the component differences of both colors plus penalties for letter and style changes
+      [[nodiscard]] auto get_color_error(const color& a, const color& b) -> int;
+      template<oof::std_string_type string_type>
+      [[nodiscard]] auto get_cell_error(const cell<string_type>& a, const cell<string_type>& b) -> int;
+
+      // A cell that differs from the input in every property
+      template<oof::std_string_type string_type>
+      [[nodiscard]] auto get_inverted_cell(const cell<string_type>& in) -> cell<string_type>;
 
       template<oof::std_string_type string_type>
       auto write_sequence_string_no_reserve(const std::vector<sequence_variant_type>& sequences, string_type& target) -> void;
@@ -267,11 +1171,23 @@ namespace oof
       template<oof::sequence_c sequence_type>
       [[nodiscard]] constexpr auto get_sequence_string_size(const sequence_type& sequence) -> size_t;
 
-      template<oof::std_string_type string_type, std::integral int_type>
-      auto write_int_to_string(string_type& target, const int_type value, const bool with_leading_semicolon) -> void;
+      // Upper bound of get_sequence_string_size() for any parameters of that sequence type
+      template<oof::sequence_c sequence_type>
+      [[nodiscard]] constexpr auto get_max_sequence_string_size() -> size_t;
+
+      // The formatting of write_sequence_into_string(). target_type is anything with a value_type and an operator+=
+      // for single letters
+      template<typename target_type, oof::sequence_c sequence_type>
+      constexpr auto write_sequence_chars(target_type& target, const sequence_type& sequence) -> void;
 
+      template<typename target_type, std::integral int_type>
+      constexpr auto write_int_to_string(target_type& target, const int_type value, const bool with_leading_semicolon) -> void;
+
+      // Row-major position that carries its column and line along, so that moving with operator++ doesn't divide
       struct cell_pos {
          int m_index = 0;
+         int m_column = 0;
+         int m_line = 0;
          int m_width = 0;
          int m_height = 0;
 
@@ -280,21 +1196,33 @@ namespace oof
             , m_height(height)
          {}
          [[nodiscard]] constexpr auto get_column() const -> int {
-            return m_index % m_width;
+            return m_column;
          }
          [[nodiscard]] constexpr auto get_line() const -> int {
-            return m_index / m_width;
+            return m_line;
          }
          [[nodiscard]] constexpr auto is_end() const -> bool {
             return m_index >= (m_width * m_height);
          }
-         [[nodiscard]] constexpr auto operator+(const int jump_amount) const -> cell_pos {
-            cell_pos jumped_pos(m_width, m_height);
-            jumped_pos.m_index = m_index + jump_amount;
-            return jumped_pos;
+         constexpr auto set_position(const int column, const int line) -> void {
+            m_index = line * m_width + column;
+            m_column = column;
+            m_line = line;
+         }
+
+         // This costs a division. Prefer set_position() or operator++ in loops
+         constexpr auto set_index(const int index) -> void {
+            m_index = index;
+            m_column = index % m_width;
+            m_line = index / m_width;
          }
          constexpr auto operator++() -> cell_pos& {
             ++m_index;
+            if (++m_column == m_width)
+            {
+               m_column = 0;
+               ++m_line;
+            }
             return *this;
          }
          friend constexpr auto operator==(const cell_pos&, const cell_pos&) -> bool = default;
@@ -322,11 +1250,47 @@ namespace oof
          [[nodiscard]] auto is_position_sequence_necessary(const cell_pos& target_pos) const -> bool;
       };
 
-      template<oof::std_string_type string_type, typename T, typename ... Ts>
-      auto write_ints_into_string(string_type& target, const T& first, const Ts&... rest) -> void;
-
+      // The diff of a whole screen against the old cells, which are empty if nothing was written yet. This is the
+      // renderer of both screen and static_screen
       template<oof::std_string_type string_type>
-      [[nodiscard]] auto get_index_color_seq_str(const set_index_color_sequence& sequence) -> string_type;
+      auto update_screen_sequences(
+         std::vector<sequence_variant_type>& sequence_buffer,
+         std::span<const cell<string_type>> cells,
+         std::span<const cell<string_type>> old_cells,
+         int width, int height,
+         int origin_line, int origin_column,
+         bool synchronized_output
+      ) -> void;
+
+      // Upper bound of the number of sequences of a screen diff: Four format sequences, a position and a letter per
+      // cell, plus reset and sync sequences
+      [[nodiscard]] constexpr auto get_max_screen_sequence_count(const int cell_count) -> size_t {
+         return static_cast<size_t>(cell_count) * 6 + 3;
+      }
+
+      template<typename target_type, typename T, typename ... Ts>
+      constexpr auto write_ints_into_string(target_type& target, const T& first, const Ts&... rest) -> void;
+
+      template<typename target_type>
+      constexpr auto write_index_color_components(target_type& target, const set_index_color_sequence& sequence) -> void;
+
+      // The first byte of every sequence in a sequence_code_buffer
+      enum class sequence_opcode : uint8_t {
+         fg_rgb_color, fg_index_color, bg_rgb_color, bg_index_color, set_index_color,
+         position, hposition, vposition, store_position, load_position,
+         underline_on, underline_off, bold_on, bold_off, cursor_visible, cursor_invisible,
+         letter, wide_letter, reset, clear_screen,
+         move_left, move_right, move_up, move_down,
+         begin_sync, end_sync,
+         scroll_region, reset_scroll_region, scroll_up, scroll_down
+      };
+
+      auto write_varint(std::vector<uint8_t>& target, uint32_t value) -> void;
+      [[nodiscard]] auto read_varint(const uint8_t*& read_pos) -> uint32_t;
+
+      // Decodes the sequence at read_pos, calls fun with it and moves read_pos behind it
+      template<typename fun_type>
+      auto visit_sequence_code(const uint8_t*& read_pos, const fun_type& fun) -> void;
 
       template<std_string_type string_type>
       using fitting_char_sequence_t = std::conditional_t<std::is_same_v<string_type, std::string>, char_sequence, wchar_sequence>;
@@ -360,28 +1324,28 @@ namespace oof
       bool m_visibility;
    };
    struct position_sequence : detail::extender<position_sequence> {
-      uint8_t m_line;
-      uint8_t m_column;
+      uint16_t m_line;
+      uint16_t m_column;
    };
    struct hposition_sequence : detail::extender<hposition_sequence> {
-      uint8_t m_column;
+      uint16_t m_column;
    };
    struct vposition_sequence : detail::extender<vposition_sequence> {
-      uint8_t m_line;
+      uint16_t m_line;
    };
    struct store_position_sequence : detail::extender<store_position_sequence> {};
    struct load_position_sequence : detail::extender<load_position_sequence> {};
    struct move_left_sequence : detail::extender<move_left_sequence> {
-      uint8_t m_amount;
+      uint16_t m_amount;
    };
    struct move_right_sequence : detail::extender<move_right_sequence> {
-      uint8_t m_amount;
+      uint16_t m_amount;
    };
    struct move_up_sequence : detail::extender<move_up_sequence> {
-      uint8_t m_amount;
+      uint16_t m_amount;
    };
    struct move_down_sequence : detail::extender<move_down_sequence> {
-      uint8_t m_amount;
+      uint16_t m_amount;
    };
    struct char_sequence : detail::extender<char_sequence> {
       char m_letter;
@@ -391,6 +1355,76 @@ namespace oof
    };
    struct reset_sequence : detail::extender<reset_sequence> {};
    struct clear_screen_sequence : detail::extender<clear_screen_sequence> {};
+   struct begin_sync_sequence : detail::extender<begin_sync_sequence> {};
+   struct end_sync_sequence : detail::extender<end_sync_sequence> {};
+   struct scroll_region_sequence : detail::extender<scroll_region_sequence> {
+      uint16_t m_top_line;
+      uint16_t m_bottom_line;
+   };
+   struct reset_scroll_region_sequence : detail::extender<reset_scroll_region_sequence> {};
+   struct scroll_up_sequence : detail::extender<scroll_up_sequence> {
+      uint16_t m_amount;
+   };
+   struct scroll_down_sequence : detail::extender<scroll_down_sequence> {
+      uint16_t m_amount;
+   };
+
+
+   // Sequences formatted at compile time, see compose_sequences(). Not null-terminated
+   template<typename char_type, size_t capacity>
+   struct static_sequence_string {
+      using value_type = char_type;
+      std::array<char_type, capacity> m_letters{};
+      size_t m_size = 0;
+
+      constexpr auto operator+=(const char_type letter) -> static_sequence_string& {
+         m_letters[m_size++] = letter;
+         return *this;
+      }
+      [[nodiscard]] constexpr auto get_view() const -> std::basic_string_view<char_type> {
+         return std::basic_string_view<char_type>(m_letters.data(), m_size);
+      }
+      [[nodiscard]] constexpr operator std::basic_string_view<char_type>() const {
+         return this->get_view();
+      }
+   };
+
+   // Formats sequences into one string with the same output as write_sequence_into_string(). In a constant
+   // expression, this leaves nothing to do at runtime but copying the letters:
+   //    static constexpr auto warning_style = oof::compose_sequences<char>(oof::fg_color(oof::color{ 255, 0, 0 }), oof::bold());
+   //    buffer += warning_style.get_view();
+   template<typename char_type, oof::sequence_c ... sequence_types>
+   [[nodiscard]] constexpr auto compose_sequences(const sequence_types&... sequences) -> static_sequence_string<char_type, (detail::get_max_sequence_string_size<sequence_types>() + ... + 0)>;
+
+
+   // Compact alternative to a vector of sequence_variant_type: Every sequence is one opcode byte followed by only the
+   // parameter bytes it needs. Numbers are varints with 7 bits per byte, and booleans are part of the opcode. Converts
+   // from and to the variant vector.
+   struct sequence_code_buffer {
+      explicit sequence_code_buffer() = default;
+      explicit sequence_code_buffer(const std::vector<sequence_variant_type>& sequences);
+
+      auto push_back(const sequence_variant_type& sequence) -> void;
+      auto clear() -> void;
+      [[nodiscard]] auto empty() const -> bool;
+      [[nodiscard]] auto get_sequence_count() const -> size_t;
+      [[nodiscard]] auto get_byte_size() const -> size_t;
+      [[nodiscard]] auto get_bytes() const -> std::span<const uint8_t>;
+      [[nodiscard]] auto get_sequences() const -> std::vector<sequence_variant_type>;
+
+   private:
+      std::vector<uint8_t> m_bytes;
+      size_t m_sequence_count = 0;
+   };
+
+   // Appends all sequences of the buffer to the string
+   template<oof::std_string_type string_type>
+   auto write_sequences_into_string(string_type& target, const sequence_code_buffer& sequences) -> void;
+
+   template<oof::std_string_type string_type>
+   [[nodiscard]] auto get_string_from_sequences(const sequence_code_buffer& sequences) -> string_type;
+
+   [[nodiscard]] auto get_string_reserve_size(const sequence_code_buffer& sequences) -> size_t;
 
 } // namespace oof
 
@@ -400,9 +1434,11 @@ template<oof::sequence_c sequence_type>
 constexpr auto oof::detail::get_sequence_string_size(const sequence_type& sequence) -> size_t
 {
    constexpr auto get_int_param_str_length = [](const int param) -> int {
-      if (param < 10)  return 1;
-      if (param < 100) return 2;
-                       return 3;
+      if (param < 10)    return 1;
+      if (param < 100)   return 2;
+      if (param < 1000)  return 3;
+      if (param < 10000) return 4;
+                         return 5;
    };
 
    if constexpr (is_any_of<sequence_type, char_sequence, wchar_sequence>) {
@@ -412,10 +1448,10 @@ constexpr auto oof::detail::get_sequence_string_size(const sequence_type& sequen
       size_t reserve_size = 0;
       reserve_size += 4; // \x1b]4;
       reserve_size += get_int_param_str_length(sequence.m_index); // <i>;
-      reserve_size += 4; // ;rgb:
+      reserve_size += 5; // ;rgb:
 
       constexpr auto get_component_str_size = [](const uint8_t component) {
-         return component < 15 ? 2 : 1;
+         return component > 15 ? 2 : 1;
       };
       reserve_size += get_component_str_size(sequence.m_color.red);
       reserve_size += 1; // /
@@ -463,11 +1499,21 @@ constexpr auto oof::detail::get_sequence_string_size(const sequence_type& sequen
       {
          reserve_size += 3;
       }
-      else if constexpr (is_any_of<sequence_type, move_left_sequence, move_right_sequence, move_up_sequence, move_down_sequence>)
+      else if constexpr (is_any_of<sequence_type, begin_sync_sequence, end_sync_sequence>)
+      {
+         reserve_size += 5;
+      }
+      else if constexpr (is_any_of<sequence_type, move_left_sequence, move_right_sequence, move_up_sequence, move_down_sequence, scroll_up_sequence, scroll_down_sequence>)
       {
          reserve_size += get_int_param_str_length(sequence.m_amount);
       }
-      else if constexpr (std::is_same_v<sequence_type, fg_index_color_sequence>)
+      else if constexpr (std::is_same_v<sequence_type, scroll_region_sequence>)
+      {
+         reserve_size += get_int_param_str_length(sequence.m_top_line + 1);
+         reserve_size += semicolon_size;
+         reserve_size += get_int_param_str_length(sequence.m_bottom_line + 1);
+      }
+      else if constexpr (is_any_of<sequence_type, fg_index_color_sequence, bg_index_color_sequence>)
       {
          reserve_size += 5; // "38;5;"
          reserve_size += get_int_param_str_length(sequence.m_index);
@@ -479,68 +1525,52 @@ constexpr auto oof::detail::get_sequence_string_size(const sequence_type& sequen
 }
 
 
-// This will deliberately be instantiated at compiletime
-template<typename stream_type, oof::sequence_c sequence_type>
-auto oof::operator<<(stream_type& os, const sequence_type& sequence) -> stream_type&
-{
-   using char_type = typename stream_type::char_type;
-   using string_type = std::basic_string<char_type>;
-   string_type temp_string{};
-   temp_string.reserve(detail::get_sequence_string_size(sequence));
-   write_sequence_into_string(temp_string, sequence);
-   os << temp_string;
-   return os;
-}
-
-
-#ifdef OOF_IMPL
-
-// Instantiated by write_ints_into_string()
-template<oof::std_string_type string_type, std::integral int_type>
-auto oof::detail::write_int_to_string(
-   string_type& target,
+// Also the base of compose_sequences() and write_sequence_into_string(), therefore defined here
+template<typename target_type, std::integral int_type>
+constexpr auto oof::detail::write_int_to_string(
+   target_type& target,
    const int_type value,
    const bool with_leading_semicolon
 ) -> void
 {
-   using char_type = typename string_type::value_type;
+   using char_type = typename target_type::value_type;
 
    if (with_leading_semicolon)
       target += static_cast<char_type>(';');
 
-   const int hundreds = value / 100;
+   if (value >= 10000)
+      target += static_cast<char_type>('0' + (value / 10000) % 10);
+   if (value >= 1000)
+      target += static_cast<char_type>('0' + (value / 1000) % 10);
    if (value >= 100)
-      target += static_cast<char_type>('0' + hundreds);
+      target += static_cast<char_type>('0' + (value / 100) % 10);
    if (value >= 10)
-      target += static_cast<char_type>('0' + (value % 100) / 10);
-   target += '0' + value % 10;
+      target += static_cast<char_type>('0' + (value / 10) % 10);
+   target += static_cast<char_type>('0' + value % 10);
 }
 
 
-// Instantiated by write_sequence_into_string()
-template<oof::std_string_type string_type, typename T, typename ... Ts>
-auto oof::detail::write_ints_into_string(string_type& target, const T& first, const Ts&... rest) -> void
+template<typename target_type, typename T, typename ... Ts>
+constexpr auto oof::detail::write_ints_into_string(target_type& target, const T& first, const Ts&... rest) -> void
 {
    detail::write_int_to_string(target, first, false);
    (detail::write_int_to_string(target, rest, true), ...);
 }
 
 
-// Instantiated by write_sequence_string_no_reserve()
-template<oof::std_string_type string_type, oof::sequence_c sequence_type>
-auto oof::write_sequence_into_string(
-   string_type& target,
+template<typename target_type, oof::sequence_c sequence_type>
+constexpr auto oof::detail::write_sequence_chars(
+   target_type& target,
    const sequence_type& sequence
 ) -> void
 {
-   if constexpr (std::is_same_v<sequence_type, detail::fitting_char_sequence_t<string_type>>)
+   using char_type = typename target_type::value_type;
+   if constexpr (std::is_same_v<sequence_type, fitting_char_sequence_t<std::basic_string<char_type>>>)
    {
       target += sequence.m_letter;
    }
    else
    {
-      using char_type = typename string_type::value_type;
-
       target += static_cast<char_type>('\x1b');
       if constexpr (std::same_as<sequence_type, set_index_color_sequence>)
          target += static_cast<char_type>(']');
@@ -569,7 +1599,7 @@ auto oof::write_sequence_into_string(
       else if constexpr (std::is_same_v<sequence_type, set_index_color_sequence>)
       {
          detail::write_ints_into_string(target, 4, sequence.m_index);
-         target += detail::get_index_color_seq_str<string_type>(sequence);
+         detail::write_index_color_components(target, sequence);
       }
       else if constexpr (std::is_same_v<sequence_type, bg_rgb_color_sequence>)
       {
@@ -592,6 +1622,18 @@ auto oof::write_sequence_into_string(
          detail::write_ints_into_string(target, 25);
          target += static_cast<char_type>(sequence.m_visibility ? 'h' : 'l');
       }
+      else if constexpr (std::is_same_v<sequence_type, begin_sync_sequence>)
+      {
+         target += static_cast<char_type>('?');
+         detail::write_ints_into_string(target, 2026);
+         target += static_cast<char_type>('h');
+      }
+      else if constexpr (std::is_same_v<sequence_type, end_sync_sequence>)
+      {
+         target += static_cast<char_type>('?');
+         detail::write_ints_into_string(target, 2026);
+         target += static_cast<char_type>('l');
+      }
       else if constexpr (std::is_same_v<sequence_type, position_sequence>)
       {
          detail::write_ints_into_string(target, sequence.m_line + 1, sequence.m_column + 1);
@@ -645,28 +1687,45 @@ auto oof::write_sequence_into_string(
          detail::write_ints_into_string(target, 2);
          target += static_cast<char_type>('J');
       }
+      else if constexpr (std::is_same_v<sequence_type, scroll_region_sequence>)
+      {
+         detail::write_ints_into_string(target, sequence.m_top_line + 1, sequence.m_bottom_line + 1);
+         target += static_cast<char_type>('r');
+      }
+      else if constexpr (std::is_same_v<sequence_type, reset_scroll_region_sequence>)
+      {
+         target += static_cast<char_type>('r');
+      }
+      else if constexpr (std::is_same_v<sequence_type, scroll_up_sequence>)
+      {
+         detail::write_ints_into_string(target, sequence.m_amount);
+         target += static_cast<char_type>('S');
+      }
+      else if constexpr (std::is_same_v<sequence_type, scroll_down_sequence>)
+      {
+         detail::write_ints_into_string(target, sequence.m_amount);
+         target += static_cast<char_type>('T');
+      }
    }
 }
 
 
-template<oof::std_string_type string_type>
-auto oof::detail::get_index_color_seq_str(
+template<typename target_type>
+constexpr auto oof::detail::write_index_color_components(
+   target_type& target,
    const set_index_color_sequence& sequence
-) -> string_type
+) -> void
 {
-   using char_type = typename string_type::value_type;
+   using char_type = typename target_type::value_type;
 
-   string_type result;
-   if constexpr (std::same_as<string_type, std::string>)
-      result = ";rgb:";
-   else
-      result = L";rgb:";
+   for (const char letter : { ';', 'r', 'g', 'b', ':' })
+      target += static_cast<char_type>(letter);
 
    const auto write_nibble = [&](const int nibble) {
       if (nibble < 10)
-         result += static_cast<char_type>('0' + nibble);
+         target += static_cast<char_type>('0' + nibble);
       else
-         result += static_cast<char_type>('a' + nibble - 10);
+         target += static_cast<char_type>('a' + nibble - 10);
    };
    const auto write_component = [&](const uint8_t component) {
       if (component > 15)
@@ -674,299 +1733,111 @@ auto oof::detail::get_index_color_seq_str(
       write_nibble(component & 0xf);
    };
    write_component(sequence.m_color.red);
-   result += static_cast<char_type>('/');
+   target += static_cast<char_type>('/');
    write_component(sequence.m_color.green);
-   result += static_cast<char_type>('/');
+   target += static_cast<char_type>('/');
    write_component(sequence.m_color.blue);
-   result += static_cast<char_type>('\x1b');
-   result += static_cast<char_type>('\x5c');
-   return result;
-}
-
-
-template<oof::std_string_type string_type>
-auto oof::screen<string_type>::update_sequence_buffer() const -> void
-{
-   detail::draw_state<string_type> state{};
-   m_sequence_buffer.clear();
-   m_sequence_buffer.push_back(reset_sequence{});
-
-   for (detail::cell_pos relative_pos{ this->m_width, this->m_height }; relative_pos.is_end() == false; ++relative_pos)
-   {
-      const cell<string_type>& target_cell_state = this->m_cells[relative_pos.m_index];
-
-      std::optional<std::reference_wrapper<const cell<string_type>>> old_cell_state;
-      if (this->m_old_cells.empty() == false)
-         old_cell_state.emplace(this->m_old_cells[relative_pos.m_index]);
-
-      state.write_sequence(
-         m_sequence_buffer,
-         target_cell_state, old_cell_state,
-         relative_pos,
-         this->m_origin_line, this->m_origin_column
-      );
-   }
-}
-
-
-template<oof::std_string_type string_type>
-oof::screen<string_type>::screen(
-   const int width, const int height,
-   const int start_column, const int start_line,
-   const cell<string_type>& background
-)
-   : m_width(width)
-   , m_height(height)
-   , m_origin_line(start_line)
-   , m_origin_column(start_column)
-   , m_background(background)
-   , m_cells(width* height, background)
-{
-   if (width <= 0)
-   {
-      const std::string msg = "Width can't be negative";
-      ::oof::detail::error(msg);
-   }
-   if (height <= 0)
-   {
-      const std::string msg = "Height can't be negative";
-      ::oof::detail::error(msg);
-   }
-}
-
-
-template<oof::std_string_type string_type>
-oof::screen<string_type>::screen(
-   const int width, const int height,
-   const int start_column, const int start_line,
-   const char_type fill_char
-)
-   : screen(width, height, start_column, start_line, cell<string_type>{fill_char})
-{
-   
+   target += static_cast<char_type>('\x1b');
+   target += static_cast<char_type>('\x5c');
 }
 
 
-template<oof::std_string_type string_type>
-oof::screen<string_type>::screen(
-   const int width, const int height,
-   const char_type fill_char
-)
-   : screen(width, height, 0, 0, fill_char)
-{
-
-}
-
-
-template <oof::std_string_type string_type>
-auto oof::screen<string_type>::get_width() const -> int
-{
-   return m_width;
-}
-
-
-template <oof::std_string_type string_type>
-auto oof::screen<string_type>::get_height() const -> int
+template<oof::sequence_c sequence_type>
+constexpr auto oof::detail::get_max_sequence_string_size() -> size_t
 {
-   return m_height;
+   // Every parameter at its longest
+   sequence_type sequence{};
+   if constexpr (requires { sequence.m_color; })
+      sequence.m_color = color{ 255 };
+   if constexpr (requires { sequence.m_index; })
+      sequence.m_index = 255;
+   if constexpr (requires { sequence.m_underline; })
+      sequence.m_underline = false;
+   if constexpr (requires { sequence.m_bold; })
+      sequence.m_bold = false;
+   if constexpr (requires { sequence.m_line; })
+      sequence.m_line = std::numeric_limits<uint16_t>::max();
+   if constexpr (requires { sequence.m_column; })
+      sequence.m_column = std::numeric_limits<uint16_t>::max();
+   if constexpr (requires { sequence.m_amount; })
+      sequence.m_amount = std::numeric_limits<uint16_t>::max();
+   if constexpr (requires { sequence.m_top_line; })
+      sequence.m_top_line = std::numeric_limits<uint16_t>::max();
+   if constexpr (requires { sequence.m_bottom_line; })
+      sequence.m_bottom_line = std::numeric_limits<uint16_t>::max();
+   return get_sequence_string_size(sequence);
 }
 
 
-template<oof::std_string_type string_type>
-auto oof::screen<string_type>::get_string() const -> string_type
+template<typename char_type, oof::sequence_c ... sequence_types>
+constexpr auto oof::compose_sequences(
+   const sequence_types&... sequences
+) -> static_sequence_string<char_type, (detail::get_max_sequence_string_size<sequence_types>() + ... + 0)>
 {
-   this->update_sequence_buffer();
-   string_type result = ::oof::get_string_from_sequences<string_type>(m_sequence_buffer);
-   m_old_cells = m_cells;
+   static_sequence_string<char_type, (detail::get_max_sequence_string_size<sequence_types>() + ... + 0)> result;
+   (detail::write_sequence_chars(result, sequences), ...);
    return result;
 }
 
 
-template<oof::std_string_type string_type>
-auto oof::screen<string_type>::get_string(string_type& buffer) const -> void
-{
-   this->update_sequence_buffer();
-
-   // Reserve if the string buffer is still empty (on the first call)
-   if (buffer.empty())
-      buffer.reserve(::oof::get_string_reserve_size(m_sequence_buffer));
-
-   buffer.clear();
-
-   ::oof::detail::write_sequence_string_no_reserve(m_sequence_buffer, buffer);
-   m_old_cells = m_cells;
-}
-
-
-template <oof::std_string_type string_type>
-auto oof::screen<string_type>::write_into(
-   const string_type& text,
-   const int column, const int line,
-   const cell_format& formatting
-) -> void
-{
-   if (line < 0 || line >= m_height)
-   {
-      std::string msg = "Line is out of range. Height is ";
-      msg += std::to_string(m_height);
-      msg += ", line was: ";
-      msg += std::to_string(line);
-      ::oof::detail::error(msg);
-      return;
-   }
-   if (column < 0 || column >= m_width)
-   {
-      std::string msg = "Column is out of range. Width is ";
-      msg += std::to_string(m_width);
-      msg += ", column was: ";
-      msg += std::to_string(column);
-      ::oof::detail::error(msg);
-      return;
-   }
-
-   const int ending_column = column + static_cast<int>(text.size());
-   if (ending_column > m_width)
-   {
-      ::oof::detail::error("Trying to write_into() with a text that won't fit.");
-      return;
-   }
-   for (size_t i = 0; i < text.size(); ++i) {
-      cell<string_type>& cell = m_cells[line * m_width + column + i];
-      cell.m_letter = text[i];
-      cell.m_format = formatting;
-   }
-}
-
-
-template<oof::std_string_type string_type>
-auto oof::screen<string_type>::is_inside(const int column, const int line) const -> bool
-{
-   return column >= 0 && column < m_width&& line >= 0 && line < m_height;
-}
-
-
-template<oof::std_string_type string_type>
-auto oof::screen<string_type>::get_cell(const int column, const int line) -> cell<string_type>&
-{
-   if ( line < 0 || line >= m_height)
-   {
-      std::string msg = "Line is out of range. Height is ";
-      msg += std::to_string(m_height);
-      msg += ", line was: ";
-      msg += std::to_string(line);
-      ::oof::detail::error(msg);
-      return m_cells[0];
-   }
-   if (column < 0 || column >= m_width)
-   {
-      std::string msg = "Column is out of range. Width is ";
-      msg += std::to_string(m_width);
-      msg += ", column was: ";
-      msg += std::to_string(column);
-      ::oof::detail::error(msg);
-      return m_cells[0];
-   }
-
-   const int index = line * m_width + column;
-   return m_cells[index];
-}
-template struct oof::screen<std::string>;
-template struct oof::screen<std::wstring>;
-
-
-auto oof::get_string_reserve_size(const std::vector<sequence_variant_type>& sequences) -> size_t
-{
-   size_t reserve_size{};
-   for (const sequence_variant_type& sequence : sequences)
-      std::visit([&](const auto& alternative) { reserve_size += detail::get_sequence_string_size(alternative); }, sequence);
-   return reserve_size;
-}
-
-
-// Instantiated by oof::screen<string_type>::get_string()
-template<oof::std_string_type string_type>
-auto oof::detail::write_sequence_string_no_reserve(
-   const std::vector<sequence_variant_type>& sequences,
-   string_type& target
-) -> void
-{
-   for (const sequence_variant_type& sequence : sequences)
-      std::visit([&](const auto& alternative) { write_sequence_into_string(target, alternative);  }, sequence);
-}
-
-
-template<oof::std_string_type string_type>
-auto oof::get_string_from_sequences(
-   const std::vector<sequence_variant_type>& sequences
-) -> string_type
-{
-   string_type result_str{};
-   result_str.reserve(::oof::get_string_reserve_size(sequences));
-   ::oof::detail::write_sequence_string_no_reserve(sequences, result_str);
-   return result_str;
-}
-template auto oof::get_string_from_sequences(const std::vector<sequence_variant_type>& sequences) -> std::string;
-template auto oof::get_string_from_sequences(const std::vector<sequence_variant_type>& sequences) -> std::wstring;
-
-
-auto oof::position(const int line, const int column) -> position_sequence {
+constexpr auto oof::position(const int line, const int column) -> position_sequence {
    return position_sequence{
-      .m_line = static_cast<uint8_t>(line),
-      .m_column = static_cast<uint8_t>(column)
+      .m_line = static_cast<uint16_t>(line),
+      .m_column = static_cast<uint16_t>(column)
    };
 }
 
 
-auto oof::vposition(const int line) -> vposition_sequence {
-   return vposition_sequence{ .m_line = static_cast<uint8_t>(line) };
+constexpr auto oof::vposition(const int line) -> vposition_sequence {
+   return vposition_sequence{ .m_line = static_cast<uint16_t>(line) };
 }
 
 
-auto oof::hposition(const int column) -> hposition_sequence {
-   return hposition_sequence{ .m_column = static_cast<uint8_t>(column) };
+constexpr auto oof::hposition(const int column) -> hposition_sequence {
+   return hposition_sequence{ .m_column = static_cast<uint16_t>(column) };
 }
 
-auto oof::store_position() -> store_position_sequence
+constexpr auto oof::store_position() -> store_position_sequence
 {
    return store_position_sequence{};
 }
 
-auto oof::load_position() -> load_position_sequence
+constexpr auto oof::load_position() -> load_position_sequence
 {
    return load_position_sequence{};
 }
 
 
-auto oof::move_left(const int amount) -> move_left_sequence
+constexpr auto oof::move_left(const int amount) -> move_left_sequence
 {
-   return move_left_sequence{ .m_amount = static_cast<uint8_t>(amount)};
+   return move_left_sequence{ .m_amount = static_cast<uint16_t>(amount)};
 }
 
 
-auto oof::move_right(const int amount) -> move_right_sequence
+constexpr auto oof::move_right(const int amount) -> move_right_sequence
 {
-   return move_right_sequence{ .m_amount = static_cast<uint8_t>(amount) };
+   return move_right_sequence{ .m_amount = static_cast<uint16_t>(amount) };
 }
 
 
-auto oof::move_up(const int amount) -> move_up_sequence
+constexpr auto oof::move_up(const int amount) -> move_up_sequence
 {
-   return move_up_sequence{ .m_amount = static_cast<uint8_t>(amount) };
+   return move_up_sequence{ .m_amount = static_cast<uint16_t>(amount) };
 }
 
 
-auto oof::move_down(const int amount) -> move_down_sequence
+constexpr auto oof::move_down(const int amount) -> move_down_sequence
 {
-   return move_down_sequence{ .m_amount = static_cast<uint8_t>(amount) };
+   return move_down_sequence{ .m_amount = static_cast<uint16_t>(amount) };
 }
 
 
-auto oof::fg_color(const color& col) -> fg_rgb_color_sequence {
+constexpr auto oof::fg_color(const color& col) -> fg_rgb_color_sequence {
    return fg_rgb_color_sequence{ .m_color = col };
 }
 
 
-auto oof::fg_color(const int index) -> fg_index_color_sequence
+constexpr auto oof::fg_color(const int index) -> fg_index_color_sequence
 {
    if (index < 1 || index > 255)
    {
@@ -979,7 +1850,7 @@ auto oof::fg_color(const int index) -> fg_index_color_sequence
 }
 
 
-auto oof::set_index_color(
+constexpr auto oof::set_index_color(
    const int index,
    const color& col
 ) -> set_index_color_sequence
@@ -995,13 +1866,13 @@ auto oof::set_index_color(
 }
 
 
-auto oof::bg_color(const color& col) -> bg_rgb_color_sequence
+constexpr auto oof::bg_color(const color& col) -> bg_rgb_color_sequence
 {
    return bg_rgb_color_sequence{ .m_color=col };
 }
 
 
-auto oof::bg_color(const int index) -> bg_index_color_sequence
+constexpr auto oof::bg_color(const int index) -> bg_index_color_sequence
 {
    if (index < 1 || index > 255)
    {
@@ -1012,149 +1883,2748 @@ auto oof::bg_color(const int index) -> bg_index_color_sequence
 }
 
 
-auto oof::underline(const bool new_value) -> underline_sequence
+constexpr auto oof::underline(const bool new_value) -> underline_sequence
 {
    return underline_sequence{ .m_underline=new_value };
 }
 
 
-auto oof::bold(const bool new_value) -> bold_sequence
+constexpr auto oof::bold(const bool new_value) -> bold_sequence
 {
    return bold_sequence{ .m_bold=new_value };
 }
 
 
-auto oof::cursor_visibility(const bool new_value) -> cursor_visibility_sequence
+constexpr auto oof::cursor_visibility(const bool new_value) -> cursor_visibility_sequence
 {
    return cursor_visibility_sequence{ .m_visibility=new_value };
 }
 
 
-auto oof::reset_formatting() -> reset_sequence {
-   return reset_sequence{};
+constexpr auto oof::begin_sync() -> begin_sync_sequence
+{
+   return begin_sync_sequence{};
 }
 
 
-auto oof::clear_screen() -> clear_screen_sequence {
-   return clear_screen_sequence{};
+constexpr auto oof::end_sync() -> end_sync_sequence
+{
+   return end_sync_sequence{};
 }
 
 
-oof::pixel_screen::pixel_screen(
-   const int width,
-   const int halfline_height,
-   const int start_column,
-   const int start_halfline,
-   const color& fill_color
+constexpr auto oof::scroll_region(const int top_line, const int bottom_line) -> scroll_region_sequence
+{
+   return scroll_region_sequence{
+      .m_top_line = static_cast<uint16_t>(top_line),
+      .m_bottom_line = static_cast<uint16_t>(bottom_line)
+   };
+}
+
+
+constexpr auto oof::reset_scroll_region() -> reset_scroll_region_sequence
+{
+   return reset_scroll_region_sequence{};
+}
+
+
+constexpr auto oof::scroll_up(const int amount) -> scroll_up_sequence
+{
+   return scroll_up_sequence{ .m_amount = static_cast<uint16_t>(amount) };
+}
+
+
+constexpr auto oof::scroll_down(const int amount) -> scroll_down_sequence
+{
+   return scroll_down_sequence{ .m_amount = static_cast<uint16_t>(amount) };
+}
+
+
+constexpr auto oof::reset_formatting() -> reset_sequence {
+   return reset_sequence{};
+}
+
+
+constexpr auto oof::clear_screen() -> clear_screen_sequence {
+   return clear_screen_sequence{};
+}
+
+
+// This will deliberately be instantiated at compiletime. Formats into a buffer on the stack that fits any sequence of
+// that type, so there's no allocation
+template<typename stream_type, oof::sequence_c sequence_type>
+auto oof::operator<<(stream_type& os, const sequence_type& sequence) -> stream_type&
+{
+   using char_type = typename stream_type::char_type;
+   static_sequence_string<char_type, detail::get_max_sequence_string_size<sequence_type>()> buffer;
+   detail::write_sequence_chars(buffer, sequence);
+   os.write(buffer.m_letters.data(), static_cast<std::streamsize>(buffer.m_size));
+   return os;
+}
+
+
+// Templated on its size, therefore defined here
+template<int width, int height, oof::std_string_type string_type>
+oof::static_screen<width, height, string_type>::static_screen(
+   const int start_column, const int start_line,
+   const cell<string_type>& background
 )
-   : m_fill_color(fill_color)
-   , m_halfline_height(halfline_height)
+   : m_origin_line(start_line)
    , m_origin_column(start_column)
-   , m_origin_halfline(start_halfline)
-   , m_screen(width, this->get_line_height(), m_origin_column, m_origin_halfline / 2, detail::get_pixel_background(fill_color))
-   , m_pixels(width * halfline_height, fill_color)
+   , m_background(background)
+{
+   m_cells.fill(background);
+   m_sequence_buffer.reserve(detail::get_max_screen_sequence_count(cell_count));
+}
+
+
+template<int width, int height, oof::std_string_type string_type>
+oof::static_screen<width, height, string_type>::static_screen(
+   const int start_column, const int start_line,
+   const char_type fill_char
+)
+   : static_screen(start_column, start_line, cell<string_type>{fill_char})
+{
+
+}
+
+
+template<int width, int height, oof::std_string_type string_type>
+oof::static_screen<width, height, string_type>::static_screen(const char_type fill_char)
+   : static_screen(0, 0, fill_char)
+{
+
+}
+
+
+template<int width, int height, oof::std_string_type string_type>
+auto oof::static_screen<width, height, string_type>::get_cell(const int column, const int line) -> cell<string_type>&
+{
+   if (this->is_inside(column, line) == false)
+   {
+      std::string msg = "Cell is out of range. Size is ";
+      msg += std::to_string(width);
+      msg += "x";
+      msg += std::to_string(height);
+      msg += ", cell was: ";
+      msg += std::to_string(column);
+      msg += ", ";
+      msg += std::to_string(line);
+      ::oof::detail::error(msg);
+      return m_cells[0];
+   }
+   return m_cells[line * width + column];
+}
+
+
+template<int width, int height, oof::std_string_type string_type>
+auto oof::static_screen<width, height, string_type>::is_inside(const int column, const int line) const -> bool
+{
+   return column >= 0 && column < width && line >= 0 && line < height;
+}
+
+
+template<int width, int height, oof::std_string_type string_type>
+auto oof::static_screen<width, height, string_type>::get_cells() const -> std::span<const cell<string_type>, cell_count>
+{
+   return m_cells;
+}
+
+
+template<int width, int height, oof::std_string_type string_type>
+auto oof::static_screen<width, height, string_type>::get_line(const int line) const -> std::span<const cell<string_type>>
+{
+   if (line < 0 || line >= height)
+      return {};
+   return std::span<const cell<string_type>>(m_cells).subspan(static_cast<size_t>(line) * width, width);
+}
+
+
+template<int width, int height, oof::std_string_type string_type>
+auto oof::static_screen<width, height, string_type>::get_line(const int line) -> std::span<cell<string_type>>
+{
+   if (line < 0 || line >= height)
+      return {};
+   return std::span<cell<string_type>>(m_cells).subspan(static_cast<size_t>(line) * width, width);
+}
+
+
+template<int width, int height, oof::std_string_type string_type>
+auto oof::static_screen<width, height, string_type>::get_string() const -> string_type
+{
+   string_type result;
+   this->get_string(result);
+   return result;
+}
+
+
+template<int width, int height, oof::std_string_type string_type>
+auto oof::static_screen<width, height, string_type>::get_string(string_type& buffer) const -> void
+{
+   this->update_sequence_buffer();
+   if (buffer.empty())
+      buffer.reserve(::oof::get_string_reserve_size(m_sequence_buffer));
+   buffer.clear();
+   ::oof::detail::write_sequence_string_no_reserve(m_sequence_buffer, buffer);
+   m_old_cells = m_cells;
+   m_has_old_cells = true;
+}
+
+
+template<int width, int height, oof::std_string_type string_type>
+auto oof::static_screen<width, height, string_type>::set_synchronized_output(const bool new_value) -> void
+{
+   m_synchronized_output = new_value;
+}
+
+
+template<int width, int height, oof::std_string_type string_type>
+auto oof::static_screen<width, height, string_type>::get_sequences() const -> const std::vector<sequence_variant_type>&
+{
+   return m_sequence_buffer;
+}
+
+
+template<int width, int height, oof::std_string_type string_type>
+auto oof::static_screen<width, height, string_type>::write_into(
+   const string_type& text,
+   const int column, const int line,
+   const cell_format& formatting
+) -> void
+{
+   if (this->is_inside(column, line) == false)
+   {
+      ::oof::detail::error("Trying to write_into() outside of the screen.");
+      return;
+   }
+   if (column + static_cast<int>(text.size()) > width)
+   {
+      ::oof::detail::error("Trying to write_into() with a text that won't fit.");
+      return;
+   }
+   for (size_t i = 0; i < text.size(); ++i)
+   {
+      cell<string_type>& target = m_cells[line * width + column + i];
+      target.m_letter = text[i];
+      target.m_format = formatting;
+   }
+}
+
+
+template<int width, int height, oof::std_string_type string_type>
+auto oof::static_screen<width, height, string_type>::clear() -> void
+{
+   m_cells.fill(m_background);
+}
+
+
+template<int width, int height, oof::std_string_type string_type>
+auto oof::static_screen<width, height, string_type>::update_sequence_buffer() const -> void
+{
+   std::span<const cell<string_type>> old_cells;
+   if (m_has_old_cells)
+      old_cells = m_old_cells;
+   detail::update_screen_sequences<string_type>(
+      m_sequence_buffer,
+      m_cells, old_cells,
+      width, height,
+      m_origin_line, m_origin_column,
+      m_synchronized_output
+   );
+}
+
+
+#ifdef OOF_IMPL
+
+// Instantiated by write_sequence_string_no_reserve()
+template<oof::std_string_type string_type, oof::sequence_c sequence_type>
+auto oof::write_sequence_into_string(
+   string_type& target,
+   const sequence_type& sequence
+) -> void
+{
+   detail::write_sequence_chars(target, sequence);
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::detail::update_screen_sequences(
+   std::vector<sequence_variant_type>& sequence_buffer,
+   const std::span<const cell<string_type>> cells,
+   const std::span<const cell<string_type>> old_cells,
+   const int width, const int height,
+   const int origin_line, const int origin_column,
+   const bool synchronized_output
+) -> void
+{
+   draw_state<string_type> state{};
+   sequence_buffer.clear();
+   if (synchronized_output)
+      sequence_buffer.push_back(begin_sync_sequence{});
+   sequence_buffer.push_back(reset_sequence{});
+
+   for (cell_pos relative_pos{ width, height }; relative_pos.is_end() == false; ++relative_pos)
+   {
+      const cell<string_type>& target_cell_state = cells[relative_pos.m_index];
+
+      std::optional<std::reference_wrapper<const cell<string_type>>> old_cell_state;
+      if (old_cells.empty() == false)
+         old_cell_state.emplace(old_cells[relative_pos.m_index]);
+
+      state.write_sequence(
+         sequence_buffer,
+         target_cell_state, old_cell_state,
+         relative_pos,
+         origin_line, origin_column
+      );
+   }
+   if (synchronized_output)
+      sequence_buffer.push_back(end_sync_sequence{});
+}
+template auto oof::detail::update_screen_sequences(std::vector<sequence_variant_type>&, std::span<const cell<std::string>>, std::span<const cell<std::string>>, int, int, int, int, bool) -> void;
+template auto oof::detail::update_screen_sequences(std::vector<sequence_variant_type>&, std::span<const cell<std::wstring>>, std::span<const cell<std::wstring>>, int, int, int, int, bool) -> void;
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::update_sequence_buffer() const -> void
+{
+   detail::update_screen_sequences<string_type>(
+      m_sequence_buffer,
+      m_cells, m_old_cells,
+      m_width, m_height,
+      m_origin_line, m_origin_column,
+      m_synchronized_output
+   );
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::update_sequence_buffer(const std::vector<int>& cell_indices) const -> void
+{
+   detail::draw_state<string_type> state{};
+   m_sequence_buffer.clear();
+   if (m_synchronized_output)
+      m_sequence_buffer.push_back(begin_sync_sequence{});
+   m_sequence_buffer.push_back(reset_sequence{});
+
+   detail::cell_pos relative_pos{ this->m_width, this->m_height };
+   for (const int index : cell_indices)
+   {
+      relative_pos.set_index(index);
+      state.write_sequence(
+         m_sequence_buffer,
+         this->m_cells[index], std::nullopt,
+         relative_pos,
+         this->m_origin_line, this->m_origin_column
+      );
+   }
+   if (m_synchronized_output)
+      m_sequence_buffer.push_back(end_sync_sequence{});
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::update_sequence_buffer(
+   const int first_column, const int end_column,
+   const int first_line, const int end_line
+) const -> void
+{
+   detail::draw_state<string_type> state{};
+   m_sequence_buffer.clear();
+   if (m_synchronized_output)
+      m_sequence_buffer.push_back(begin_sync_sequence{});
+   m_sequence_buffer.push_back(reset_sequence{});
+
+   detail::cell_pos relative_pos{ this->m_width, this->m_height };
+   for (int line = first_line; line < end_line; ++line)
+   {
+      relative_pos.set_position(first_column, line);
+      for (int column = first_column; column < end_column; ++column, ++relative_pos)
+      {
+         state.write_sequence(
+            m_sequence_buffer,
+            this->m_cells[relative_pos.m_index], this->m_old_cells[relative_pos.m_index],
+            relative_pos,
+            this->m_origin_line, this->m_origin_column
+         );
+      }
+   }
+   if (m_synchronized_output)
+      m_sequence_buffer.push_back(end_sync_sequence{});
+}
+
+
+// Moves the remembered lines up by amount, or down for negative amounts. Lines that are moved in are unknown
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::shift_old_lines(const int amount) const -> void
+{
+   const auto shift_begin = m_old_cells.begin() + static_cast<ptrdiff_t>(std::abs(amount)) * m_width;
+   if (amount > 0)
+      std::copy(shift_begin, m_old_cells.end(), m_old_cells.begin());
+   else
+      std::copy_backward(m_old_cells.begin(), m_old_cells.end() - (shift_begin - m_old_cells.begin()), m_old_cells.end());
+
+   const int first_unknown = amount > 0 ? (m_height - amount) * m_width : 0;
+   const int end_unknown = amount > 0 ? m_height * m_width : -amount * m_width;
+   for (int i = first_unknown; i < end_unknown; ++i)
+      m_old_cells[i] = detail::get_inverted_cell(m_cells[i]);
+}
+
+
+// Cells that were never sent are remembered as their inverse. That way they're different and have maximum error
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::initialize_old_cells() const -> void
+{
+   if (m_old_cells.empty() == false)
+      return;
+   m_old_cells.reserve(m_cells.size());
+   for (const cell<string_type>& target : m_cells)
+      m_old_cells.push_back(detail::get_inverted_cell(target));
+}
+
+
+template<oof::std_string_type string_type>
+oof::screen<string_type>::screen(
+   const int width, const int height,
+   const int start_column, const int start_line,
+   const cell<string_type>& background
+)
+   : m_width(width)
+   , m_height(height)
+   , m_origin_line(start_line)
+   , m_origin_column(start_column)
+   , m_background(background)
+   , m_cells(width* height, background)
+{
+   if (width <= 0)
+   {
+      const std::string msg = "Width can't be negative";
+      ::oof::detail::error(msg);
+   }
+   if (height <= 0)
+   {
+      const std::string msg = "Height can't be negative";
+      ::oof::detail::error(msg);
+   }
+}
+
+
+template<oof::std_string_type string_type>
+oof::screen<string_type>::screen(
+   const int width, const int height,
+   const int start_column, const int start_line,
+   const char_type fill_char
+)
+   : screen(width, height, start_column, start_line, cell<string_type>{fill_char})
+{
+   
+}
+
+
+template<oof::std_string_type string_type>
+oof::screen<string_type>::screen(
+   const int width, const int height,
+   const char_type fill_char
+)
+   : screen(width, height, 0, 0, fill_char)
+{
+
+}
+
+
+template <oof::std_string_type string_type>
+auto oof::screen<string_type>::get_width() const -> int
+{
+   return m_width;
+}
+
+
+template <oof::std_string_type string_type>
+auto oof::screen<string_type>::get_height() const -> int
+{
+   return m_height;
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::get_string() const -> string_type
+{
+   if (m_thread_count > 1)
+   {
+      string_type result;
+      this->write_string_parallel(result);
+      return result;
+   }
+
+#ifdef OOF_RENDER_STATS
+   detail::stats_recorder recorder{ m_render_stats, 0, m_sequence_buffer.capacity() };
+#endif
+   this->update_sequence_buffer();
+#ifdef OOF_RENDER_STATS
+   recorder.end_diff();
+#endif
+   string_type result = ::oof::get_string_from_sequences<string_type>(m_sequence_buffer);
+   m_old_cells = m_cells;
+#ifdef OOF_RENDER_STATS
+   recorder.finish(m_sequence_buffer, static_cast<int>(m_cells.size()), result.size(), result.capacity());
+#endif
+   return result;
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::get_string(string_type& buffer) const -> void
+{
+   if (m_thread_count > 1)
+   {
+      this->write_string_parallel(buffer);
+      return;
+   }
+
+#ifdef OOF_RENDER_STATS
+   detail::stats_recorder recorder{ m_render_stats, buffer.capacity(), m_sequence_buffer.capacity() };
+#endif
+   this->update_sequence_buffer();
+#ifdef OOF_RENDER_STATS
+   recorder.end_diff();
+#endif
+
+   // Reserve if the string buffer is still empty (on the first call)
+   if (buffer.empty())
+      buffer.reserve(::oof::get_string_reserve_size(m_sequence_buffer));
+
+   buffer.clear();
+
+   ::oof::detail::write_sequence_string_no_reserve(m_sequence_buffer, buffer);
+   m_old_cells = m_cells;
+#ifdef OOF_RENDER_STATS
+   recorder.finish(m_sequence_buffer, static_cast<int>(m_cells.size()), buffer.size(), buffer.capacity());
+#endif
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::get_string(
+   string_type& buffer,
+   const size_t byte_budget
+) const -> void
+{
+#ifdef OOF_RENDER_STATS
+   detail::stats_recorder recorder{ m_render_stats, buffer.capacity(), m_sequence_buffer.capacity() };
+#endif
+   this->initialize_old_cells();
+
+   std::vector<budget_candidate>& candidates = m_budget_candidates;
+   candidates.clear();
+   for (int i = 0; i < static_cast<int>(m_cells.size()); ++i)
+   {
+      if (m_cells[i] == m_old_cells[i])
+         continue;
+      candidates.push_back(budget_candidate{ i, this->get_priority(i), detail::get_cell_error(m_cells[i], m_old_cells[i]) });
+   }
+   std::ranges::sort(candidates, [](const budget_candidate& a, const budget_candidate& b) {
+      return std::tie(b.m_priority, b.m_error, a.m_index) < std::tie(a.m_priority, a.m_error, b.m_index);
+   });
+
+   // Sends the most important count candidates in screen order, since that's the cheapest order to write them
+   std::vector<int>& selection = m_budget_selection;
+   const auto get_size_for_count = [&](const size_t count) {
+      selection.clear();
+      for (size_t i = 0; i < count; ++i)
+         selection.push_back(candidates[i].m_index);
+      std::ranges::sort(selection);
+      this->update_sequence_buffer(selection);
+      return ::oof::get_string_reserve_size(m_sequence_buffer);
+   };
+
+   // Binary search for the largest number of cells that fits into the budget
+   size_t low = 0;
+   size_t high = candidates.size();
+   while (low < high)
+   {
+      const size_t mid = (low + high + 1) / 2;
+      if (get_size_for_count(mid) <= byte_budget)
+         low = mid;
+      else
+         high = mid - 1;
+   }
+   const size_t result_size = get_size_for_count(low);
+#ifdef OOF_RENDER_STATS
+   recorder.end_diff();
+#endif
+
+   buffer.clear();
+   if (result_size > byte_budget)
+      return;
+   buffer.reserve(result_size);
+   ::oof::detail::write_sequence_string_no_reserve(m_sequence_buffer, buffer);
+   for (const int index : selection)
+      m_old_cells[index] = m_cells[index];
+#ifdef OOF_RENDER_STATS
+   recorder.finish(m_sequence_buffer, static_cast<int>(m_cells.size()), buffer.size(), buffer.capacity());
+#endif
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::get_string(
+   string_type& buffer,
+   const int column, const int line,
+   const int width, const int height
+) const -> void
+{
+   const int first_column = std::max(column, 0);
+   const int end_column = std::min(column + width, m_width);
+   const int first_line = std::max(line, 0);
+   const int end_line = std::min(line + height, m_height);
+
+   this->initialize_old_cells();
+   if (first_column >= end_column || first_line >= end_line)
+   {
+      buffer.clear();
+      return;
+   }
+#ifdef OOF_RENDER_STATS
+   detail::stats_recorder recorder{ m_render_stats, buffer.capacity(), m_sequence_buffer.capacity() };
+#endif
+   this->update_sequence_buffer(first_column, end_column, first_line, end_line);
+#ifdef OOF_RENDER_STATS
+   recorder.end_diff();
+#endif
+
+   if (buffer.empty())
+      buffer.reserve(::oof::get_string_reserve_size(m_sequence_buffer));
+   buffer.clear();
+   ::oof::detail::write_sequence_string_no_reserve(m_sequence_buffer, buffer);
+#ifdef OOF_RENDER_STATS
+   recorder.finish(m_sequence_buffer, (end_column - first_column) * (end_line - first_line), buffer.size(), buffer.capacity());
+#endif
+
+   for (int i = first_line; i < end_line; ++i)
+   {
+      const auto row_begin = m_cells.begin() + i * m_width;
+      std::copy(row_begin + first_column, row_begin + end_column, m_old_cells.begin() + i * m_width + first_column);
+   }
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::set_priority(
+   const int column, const int line,
+   const int width, const int height,
+   const int priority
+) -> void
+{
+   m_priority_regions.push_back(
+      priority_region{
+         .m_column = column, .m_line = line,
+         .m_width = width, .m_height = height,
+         .m_priority = priority
+      }
+   );
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::clear_priorities() -> void
+{
+   m_priority_regions.clear();
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::set_synchronized_output(const bool new_value) -> void
+{
+   m_synchronized_output = new_value;
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::set_thread_count(const int thread_count) -> void
+{
+   if (thread_count < 1)
+   {
+      ::oof::detail::error("Thread count must be at least 1");
+      return;
+   }
+   m_thread_count = thread_count;
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::get_sequences() const -> const std::vector<sequence_variant_type>&
+{
+   return m_sequence_buffer;
+}
+
+
+#ifdef OOF_RENDER_STATS
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::get_render_stats() const -> const render_stats&
+{
+   return m_render_stats;
+}
+#endif
+
+
+// Every band is diffed with its own draw_state. To get the exact same output as a single draw_state, each band
+// starts with the state the previous bands left behind: The last changed cell before the band determines the cursor
+// position and the format.
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::write_string_parallel(string_type& buffer) const -> void
+{
+   const int band_count = std::min(m_thread_count, m_height);
+   const int lines_per_band = (m_height + band_count - 1) / band_count;
+   m_bands.resize(band_count);
+
+   const auto get_band_begin = [&](const int band_index) {
+      return std::min(band_index * lines_per_band, m_height) * m_width;
+   };
+   const auto is_changed = [&](const int index) {
+      return m_old_cells.empty() || m_cells[index] != m_old_cells[index];
+   };
+
+   std::barrier sync_point(band_count);
+   detail::run_parallel(band_count, [&](const int band_index) {
+      band& this_band = m_bands[band_index];
+      const int begin_index = get_band_begin(band_index);
+      const int end_index = get_band_begin(band_index + 1);
+
+      this_band.m_last_changed_index.reset();
+      for (int i = end_index - 1; i >= begin_index; --i)
+      {
+         if (is_changed(i))
+         {
+            this_band.m_last_changed_index = i;
+            break;
+         }
+      }
+      sync_point.arrive_and_wait();
+
+      detail::draw_state<string_type> state{};
+      for (int previous_band = band_index - 1; previous_band >= 0; --previous_band)
+      {
+         const std::optional<int>& handoff_index = m_bands[previous_band].m_last_changed_index;
+         if (handoff_index.has_value() == false)
+            continue;
+         state.m_last_written_pos.emplace(m_width, m_height);
+         state.m_last_written_pos->set_index(*handoff_index);
+         state.m_format = m_cells[*handoff_index].m_format;
+         break;
+      }
+
+      this_band.m_sequences.clear();
+      if (band_index == 0)
+      {
+         if (m_synchronized_output)
+            this_band.m_sequences.push_back(begin_sync_sequence{});
+         this_band.m_sequences.push_back(reset_sequence{});
+      }
+      detail::cell_pos relative_pos{ m_width, m_height };
+      for (relative_pos.set_index(begin_index); relative_pos.m_index < end_index; ++relative_pos)
+      {
+         std::optional<std::reference_wrapper<const cell<string_type>>> old_cell_state;
+         if (m_old_cells.empty() == false)
+            old_cell_state.emplace(m_old_cells[relative_pos.m_index]);
+         state.write_sequence(
+            this_band.m_sequences,
+            m_cells[relative_pos.m_index], old_cell_state,
+            relative_pos,
+            m_origin_line, m_origin_column
+         );
+      }
+      if (band_index == band_count - 1 && m_synchronized_output)
+         this_band.m_sequences.push_back(end_sync_sequence{});
+
+      this_band.m_string.clear();
+      this_band.m_string.reserve(::oof::get_string_reserve_size(this_band.m_sequences));
+      ::oof::detail::write_sequence_string_no_reserve(this_band.m_sequences, this_band.m_string);
+   });
+
+   size_t total_size = 0;
+   for (const band& b : m_bands)
+      total_size += b.m_string.size();
+   buffer.clear();
+   buffer.reserve(total_size);
+   for (const band& b : m_bands)
+      buffer += b.m_string;
+   m_old_cells = m_cells;
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::get_priority(const int cell_index) const -> int
+{
+   const int column = cell_index % m_width;
+   const int line = cell_index / m_width;
+   int result = 0;
+   for (const priority_region& region : m_priority_regions)
+   {
+      const bool is_inside_region =
+         column >= region.m_column && column < region.m_column + region.m_width &&
+         line >= region.m_line && line < region.m_line + region.m_height;
+      if (is_inside_region)
+         result = std::max(result, region.m_priority);
+   }
+   return result;
+}
+
+
+template <oof::std_string_type string_type>
+auto oof::screen<string_type>::write_into(
+   const string_type& text,
+   const int column, const int line,
+   const cell_format& formatting
+) -> void
+{
+   if (line < 0 || line >= m_height)
+   {
+      std::string msg = "Line is out of range. Height is ";
+      msg += std::to_string(m_height);
+      msg += ", line was: ";
+      msg += std::to_string(line);
+      ::oof::detail::error(msg);
+      return;
+   }
+   if (column < 0 || column >= m_width)
+   {
+      std::string msg = "Column is out of range. Width is ";
+      msg += std::to_string(m_width);
+      msg += ", column was: ";
+      msg += std::to_string(column);
+      ::oof::detail::error(msg);
+      return;
+   }
+
+   const int ending_column = column + static_cast<int>(text.size());
+   if (ending_column > m_width)
+   {
+      ::oof::detail::error("Trying to write_into() with a text that won't fit.");
+      return;
+   }
+   for (size_t i = 0; i < text.size(); ++i) {
+      cell<string_type>& cell = m_cells[line * m_width + column + i];
+      cell.m_letter = text[i];
+      cell.m_format = formatting;
+   }
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::is_inside(const int column, const int line) const -> bool
+{
+   return column >= 0 && column < m_width&& line >= 0 && line < m_height;
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::get_line(const int line) const -> std::span<const cell<string_type>>
+{
+   if (line < 0 || line >= m_height)
+      return {};
+   return std::span<const cell<string_type>>(m_cells).subspan(static_cast<size_t>(line) * m_width, m_width);
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::get_line(const int line) -> std::span<cell<string_type>>
+{
+   if (line < 0 || line >= m_height)
+      return {};
+   return std::span<cell<string_type>>(m_cells).subspan(static_cast<size_t>(line) * m_width, m_width);
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::get_cell(const int column, const int line) -> cell<string_type>&
+{
+   if ( line < 0 || line >= m_height)
+   {
+      std::string msg = "Line is out of range. Height is ";
+      msg += std::to_string(m_height);
+      msg += ", line was: ";
+      msg += std::to_string(line);
+      ::oof::detail::error(msg);
+      return m_cells[0];
+   }
+   if (column < 0 || column >= m_width)
+   {
+      std::string msg = "Column is out of range. Width is ";
+      msg += std::to_string(m_width);
+      msg += ", column was: ";
+      msg += std::to_string(column);
+      ::oof::detail::error(msg);
+      return m_cells[0];
+   }
+
+   const int index = line * m_width + column;
+   return m_cells[index];
+}
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::get_raster_view() -> detail::raster_view<cell<string_type>>
+{
+   return detail::raster_view<cell<string_type>>{ m_cells.data(), m_width, m_height };
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::draw_hline(
+   const int column, const int line,
+   const int length,
+   const cell<string_type>& value
+) -> void
+{
+   detail::fill_rect(this->get_raster_view(), column, line, length, 1, value);
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::draw_vline(
+   const int column, const int line,
+   const int length,
+   const cell<string_type>& value
+) -> void
+{
+   detail::fill_rect(this->get_raster_view(), column, line, 1, length, value);
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::fill_rect(
+   const int column, const int line,
+   const int width, const int height,
+   const cell<string_type>& value
+) -> void
+{
+   detail::fill_rect(this->get_raster_view(), column, line, width, height, value);
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::draw_rect(
+   const int column, const int line,
+   const int width, const int height,
+   const cell<string_type>& value
+) -> void
+{
+   detail::draw_rect(this->get_raster_view(), column, line, width, height, value);
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::draw_line(
+   const int column0, const int line0,
+   const int column1, const int line1,
+   const cell<string_type>& value
+) -> void
+{
+   detail::draw_line(this->get_raster_view(), column0, line0, column1, line1, value);
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::draw_circle(
+   const int center_column, const int center_line,
+   const int radius,
+   const cell<string_type>& value
+) -> void
+{
+   detail::draw_circle(this->get_raster_view(), center_column, center_line, radius, value);
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::fill_circle(
+   const int center_column, const int center_line,
+   const int radius,
+   const cell<string_type>& value
+) -> void
+{
+   detail::fill_circle(this->get_raster_view(), center_column, center_line, radius, value);
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::screen<string_type>::blit(
+   const int column, const int line,
+   const std::span<const cell<string_type>> source,
+   const int source_width
+) -> void
+{
+   detail::blit(this->get_raster_view(), column, line, source, source_width);
+}
+template struct oof::screen<std::string>;
+template struct oof::screen<std::wstring>;
+
+
+auto oof::get_string_reserve_size(const std::vector<sequence_variant_type>& sequences) -> size_t
+{
+   size_t reserve_size{};
+   for (const sequence_variant_type& sequence : sequences)
+      std::visit([&](const auto& alternative) { reserve_size += detail::get_sequence_string_size(alternative); }, sequence);
+   return reserve_size;
+}
+
+
+// Also used by static_screen, which lives outside of the implementation
+template<oof::std_string_type string_type>
+auto oof::detail::write_sequence_string_no_reserve(
+   const std::vector<sequence_variant_type>& sequences,
+   string_type& target
+) -> void
+{
+   for (const sequence_variant_type& sequence : sequences)
+      std::visit([&](const auto& alternative) { write_sequence_into_string(target, alternative);  }, sequence);
+}
+template auto oof::detail::write_sequence_string_no_reserve(const std::vector<sequence_variant_type>& sequences, std::string& target) -> void;
+template auto oof::detail::write_sequence_string_no_reserve(const std::vector<sequence_variant_type>& sequences, std::wstring& target) -> void;
+
+
+template<oof::std_string_type string_type>
+auto oof::get_string_from_sequences(
+   const std::vector<sequence_variant_type>& sequences
+) -> string_type
+{
+   string_type result_str{};
+   result_str.reserve(::oof::get_string_reserve_size(sequences));
+   ::oof::detail::write_sequence_string_no_reserve(sequences, result_str);
+   return result_str;
+}
+template auto oof::get_string_from_sequences(const std::vector<sequence_variant_type>& sequences) -> std::string;
+template auto oof::get_string_from_sequences(const std::vector<sequence_variant_type>& sequences) -> std::wstring;
+
+
+auto oof::detail::write_varint(std::vector<uint8_t>& target, uint32_t value) -> void
+{
+   while (value >= 0x80)
+   {
+      target.push_back(static_cast<uint8_t>(value | 0x80));
+      value >>= 7;
+   }
+   target.push_back(static_cast<uint8_t>(value));
+}
+
+
+auto oof::detail::read_varint(const uint8_t*& read_pos) -> uint32_t
+{
+   uint32_t result = 0;
+   int shift = 0;
+   while (*read_pos & 0x80)
+   {
+      result |= static_cast<uint32_t>(*read_pos++ & 0x7f) << shift;
+      shift += 7;
+   }
+   result |= static_cast<uint32_t>(*read_pos++) << shift;
+   return result;
+}
+
+
+template<typename fun_type>
+auto oof::detail::visit_sequence_code(
+   const uint8_t*& read_pos,
+   const fun_type& fun
+) -> void
+{
+   const auto read_color = [&] {
+      const color result{ read_pos[0], read_pos[1], read_pos[2] };
+      read_pos += 3;
+      return result;
+   };
+   const auto read_uint16 = [&] {
+      return static_cast<uint16_t>(read_varint(read_pos));
+   };
+   const auto read_int = [&] {
+      return static_cast<int>(read_varint(read_pos));
+   };
+
+   switch (static_cast<sequence_opcode>(*read_pos++))
+   {
+   case sequence_opcode::fg_rgb_color:
+      fun(fg_rgb_color_sequence{ .m_color = read_color() });
+      break;
+   case sequence_opcode::fg_index_color:
+      fun(fg_index_color_sequence{ .m_index = read_int() });
+      break;
+   case sequence_opcode::bg_rgb_color:
+      fun(bg_rgb_color_sequence{ .m_color = read_color() });
+      break;
+   case sequence_opcode::bg_index_color:
+      fun(bg_index_color_sequence{ .m_index = read_int() });
+      break;
+   case sequence_opcode::set_index_color:
+   {
+      const int index = read_int();
+      fun(set_index_color_sequence{ .m_index = index, .m_color = read_color() });
+      break;
+   }
+   case sequence_opcode::position:
+   {
+      const uint16_t line = read_uint16();
+      fun(position_sequence{ .m_line = line, .m_column = read_uint16() });
+      break;
+   }
+   case sequence_opcode::hposition:
+      fun(hposition_sequence{ .m_column = read_uint16() });
+      break;
+   case sequence_opcode::vposition:
+      fun(vposition_sequence{ .m_line = read_uint16() });
+      break;
+   case sequence_opcode::store_position:
+      fun(store_position_sequence{});
+      break;
+   case sequence_opcode::load_position:
+      fun(load_position_sequence{});
+      break;
+   case sequence_opcode::underline_on:
+   case sequence_opcode::underline_off:
+      fun(underline_sequence{ .m_underline = read_pos[-1] == static_cast<uint8_t>(sequence_opcode::underline_on) });
+      break;
+   case sequence_opcode::bold_on:
+   case sequence_opcode::bold_off:
+      fun(bold_sequence{ .m_bold = read_pos[-1] == static_cast<uint8_t>(sequence_opcode::bold_on) });
+      break;
+   case sequence_opcode::cursor_visible:
+   case sequence_opcode::cursor_invisible:
+      fun(cursor_visibility_sequence{ .m_visibility = read_pos[-1] == static_cast<uint8_t>(sequence_opcode::cursor_visible) });
+      break;
+   case sequence_opcode::letter:
+      fun(char_sequence{ .m_letter = static_cast<char>(*read_pos++) });
+      break;
+   case sequence_opcode::wide_letter:
+      fun(wchar_sequence{ .m_letter = static_cast<wchar_t>(read_varint(read_pos)) });
+      break;
+   case sequence_opcode::reset:
+      fun(reset_sequence{});
+      break;
+   case sequence_opcode::clear_screen:
+      fun(clear_screen_sequence{});
+      break;
+   case sequence_opcode::move_left:
+      fun(move_left_sequence{ .m_amount = read_uint16() });
+      break;
+   case sequence_opcode::move_right:
+      fun(move_right_sequence{ .m_amount = read_uint16() });
+      break;
+   case sequence_opcode::move_up:
+      fun(move_up_sequence{ .m_amount = read_uint16() });
+      break;
+   case sequence_opcode::move_down:
+      fun(move_down_sequence{ .m_amount = read_uint16() });
+      break;
+   case sequence_opcode::begin_sync:
+      fun(begin_sync_sequence{});
+      break;
+   case sequence_opcode::end_sync:
+      fun(end_sync_sequence{});
+      break;
+   case sequence_opcode::scroll_region:
+   {
+      const uint16_t top_line = read_uint16();
+      fun(scroll_region_sequence{ .m_top_line = top_line, .m_bottom_line = read_uint16() });
+      break;
+   }
+   case sequence_opcode::reset_scroll_region:
+      fun(reset_scroll_region_sequence{});
+      break;
+   case sequence_opcode::scroll_up:
+      fun(scroll_up_sequence{ .m_amount = read_uint16() });
+      break;
+   case sequence_opcode::scroll_down:
+      fun(scroll_down_sequence{ .m_amount = read_uint16() });
+      break;
+   }
+}
+
+
+oof::sequence_code_buffer::sequence_code_buffer(const std::vector<sequence_variant_type>& sequences)
+{
+   m_bytes.reserve(sequences.size() * 2);
+   for (const sequence_variant_type& sequence : sequences)
+      this->push_back(sequence);
+}
+
+
+auto oof::sequence_code_buffer::push_back(const sequence_variant_type& sequence) -> void
+{
+   using detail::sequence_opcode;
+   const auto write_opcode = [&](const sequence_opcode opcode) {
+      m_bytes.push_back(static_cast<uint8_t>(opcode));
+   };
+   const auto write_color = [&](const color& col) {
+      m_bytes.push_back(col.red);
+      m_bytes.push_back(col.green);
+      m_bytes.push_back(col.blue);
+   };
+   const auto write_number = [&](const auto value) {
+      detail::write_varint(m_bytes, static_cast<uint32_t>(value));
+   };
+
+   std::visit([&]<typename sequence_type>(const sequence_type& alternative) {
+      if constexpr (std::is_same_v<sequence_type, fg_rgb_color_sequence>) {
+         write_opcode(sequence_opcode::fg_rgb_color);
+         write_color(alternative.m_color);
+      }
+      else if constexpr (std::is_same_v<sequence_type, fg_index_color_sequence>) {
+         write_opcode(sequence_opcode::fg_index_color);
+         write_number(alternative.m_index);
+      }
+      else if constexpr (std::is_same_v<sequence_type, bg_rgb_color_sequence>) {
+         write_opcode(sequence_opcode::bg_rgb_color);
+         write_color(alternative.m_color);
+      }
+      else if constexpr (std::is_same_v<sequence_type, bg_index_color_sequence>) {
+         write_opcode(sequence_opcode::bg_index_color);
+         write_number(alternative.m_index);
+      }
+      else if constexpr (std::is_same_v<sequence_type, set_index_color_sequence>) {
+         write_opcode(sequence_opcode::set_index_color);
+         write_number(alternative.m_index);
+         write_color(alternative.m_color);
+      }
+      else if constexpr (std::is_same_v<sequence_type, position_sequence>) {
+         write_opcode(sequence_opcode::position);
+         write_number(alternative.m_line);
+         write_number(alternative.m_column);
+      }
+      else if constexpr (std::is_same_v<sequence_type, hposition_sequence>) {
+         write_opcode(sequence_opcode::hposition);
+         write_number(alternative.m_column);
+      }
+      else if constexpr (std::is_same_v<sequence_type, vposition_sequence>) {
+         write_opcode(sequence_opcode::vposition);
+         write_number(alternative.m_line);
+      }
+      else if constexpr (std::is_same_v<sequence_type, store_position_sequence>)
+         write_opcode(sequence_opcode::store_position);
+      else if constexpr (std::is_same_v<sequence_type, load_position_sequence>)
+         write_opcode(sequence_opcode::load_position);
+      else if constexpr (std::is_same_v<sequence_type, underline_sequence>)
+         write_opcode(alternative.m_underline ? sequence_opcode::underline_on : sequence_opcode::underline_off);
+      else if constexpr (std::is_same_v<sequence_type, bold_sequence>)
+         write_opcode(alternative.m_bold ? sequence_opcode::bold_on : sequence_opcode::bold_off);
+      else if constexpr (std::is_same_v<sequence_type, cursor_visibility_sequence>)
+         write_opcode(alternative.m_visibility ? sequence_opcode::cursor_visible : sequence_opcode::cursor_invisible);
+      else if constexpr (std::is_same_v<sequence_type, char_sequence>) {
+         write_opcode(sequence_opcode::letter);
+         m_bytes.push_back(static_cast<uint8_t>(alternative.m_letter));
+      }
+      else if constexpr (std::is_same_v<sequence_type, wchar_sequence>) {
+         write_opcode(sequence_opcode::wide_letter);
+         write_number(alternative.m_letter);
+      }
+      else if constexpr (std::is_same_v<sequence_type, reset_sequence>)
+         write_opcode(sequence_opcode::reset);
+      else if constexpr (std::is_same_v<sequence_type, clear_screen_sequence>)
+         write_opcode(sequence_opcode::clear_screen);
+      else if constexpr (std::is_same_v<sequence_type, move_left_sequence>) {
+         write_opcode(sequence_opcode::move_left);
+         write_number(alternative.m_amount);
+      }
+      else if constexpr (std::is_same_v<sequence_type, move_right_sequence>) {
+         write_opcode(sequence_opcode::move_right);
+         write_number(alternative.m_amount);
+      }
+      else if constexpr (std::is_same_v<sequence_type, move_up_sequence>) {
+         write_opcode(sequence_opcode::move_up);
+         write_number(alternative.m_amount);
+      }
+      else if constexpr (std::is_same_v<sequence_type, move_down_sequence>) {
+         write_opcode(sequence_opcode::move_down);
+         write_number(alternative.m_amount);
+      }
+      else if constexpr (std::is_same_v<sequence_type, begin_sync_sequence>)
+         write_opcode(sequence_opcode::begin_sync);
+      else if constexpr (std::is_same_v<sequence_type, end_sync_sequence>)
+         write_opcode(sequence_opcode::end_sync);
+      else if constexpr (std::is_same_v<sequence_type, scroll_region_sequence>) {
+         write_opcode(sequence_opcode::scroll_region);
+         write_number(alternative.m_top_line);
+         write_number(alternative.m_bottom_line);
+      }
+      else if constexpr (std::is_same_v<sequence_type, reset_scroll_region_sequence>)
+         write_opcode(sequence_opcode::reset_scroll_region);
+      else if constexpr (std::is_same_v<sequence_type, scroll_up_sequence>) {
+         write_opcode(sequence_opcode::scroll_up);
+         write_number(alternative.m_amount);
+      }
+      else if constexpr (std::is_same_v<sequence_type, scroll_down_sequence>) {
+         write_opcode(sequence_opcode::scroll_down);
+         write_number(alternative.m_amount);
+      }
+   }, sequence);
+   ++m_sequence_count;
+}
+
+
+auto oof::sequence_code_buffer::clear() -> void
+{
+   m_bytes.clear();
+   m_sequence_count = 0;
+}
+
+
+auto oof::sequence_code_buffer::empty() const -> bool
+{
+   return m_sequence_count == 0;
+}
+
+
+auto oof::sequence_code_buffer::get_sequence_count() const -> size_t
+{
+   return m_sequence_count;
+}
+
+
+auto oof::sequence_code_buffer::get_byte_size() const -> size_t
+{
+   return m_bytes.size();
+}
+
+
+auto oof::sequence_code_buffer::get_bytes() const -> std::span<const uint8_t>
+{
+   return m_bytes;
+}
+
+
+auto oof::sequence_code_buffer::get_sequences() const -> std::vector<sequence_variant_type>
+{
+   std::vector<sequence_variant_type> result;
+   result.reserve(m_sequence_count);
+   const uint8_t* read_pos = m_bytes.data();
+   const uint8_t* const end = m_bytes.data() + m_bytes.size();
+   while (read_pos < end)
+      detail::visit_sequence_code(read_pos, [&](const auto& sequence) { result.emplace_back(sequence); });
+   return result;
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::write_sequences_into_string(
+   string_type& target,
+   const sequence_code_buffer& sequences
+) -> void
+{
+   const std::span<const uint8_t> bytes = sequences.get_bytes();
+   const uint8_t* read_pos = bytes.data();
+   const uint8_t* const end = bytes.data() + bytes.size();
+   while (read_pos < end)
+      detail::visit_sequence_code(read_pos, [&](const auto& sequence) { detail::write_sequence_chars(target, sequence); });
+}
+template auto oof::write_sequences_into_string(std::string& target, const sequence_code_buffer& sequences) -> void;
+template auto oof::write_sequences_into_string(std::wstring& target, const sequence_code_buffer& sequences) -> void;
+
+
+template<oof::std_string_type string_type>
+auto oof::get_string_from_sequences(
+   const sequence_code_buffer& sequences
+) -> string_type
+{
+   string_type result_str{};
+   result_str.reserve(::oof::get_string_reserve_size(sequences));
+   ::oof::write_sequences_into_string(result_str, sequences);
+   return result_str;
+}
+template auto oof::get_string_from_sequences(const sequence_code_buffer& sequences) -> std::string;
+template auto oof::get_string_from_sequences(const sequence_code_buffer& sequences) -> std::wstring;
+
+
+auto oof::get_string_reserve_size(const sequence_code_buffer& sequences) -> size_t
+{
+   size_t reserve_size{};
+   const std::span<const uint8_t> bytes = sequences.get_bytes();
+   const uint8_t* read_pos = bytes.data();
+   const uint8_t* const end = bytes.data() + bytes.size();
+   while (read_pos < end)
+      detail::visit_sequence_code(read_pos, [&](const auto& sequence) { reserve_size += detail::get_sequence_string_size(sequence); });
+   return reserve_size;
+}
+
+
+oof::sprite::sprite(const int width, const int height, const std::vector<color>& pixels)
+   : sprite(width, height, pixels, std::vector<uint8_t>(pixels.size(), 255))
+{
+
+}
+
+
+oof::sprite::sprite(
+   const int width, const int height,
+   const std::vector<color>& pixels,
+   const std::vector<uint8_t>& alpha_mask
+)
+   : m_width(width)
+   , m_height(height)
+   , m_pixels(pixels)
+{
+   if (width < 0 || height < 0 || pixels.size() != static_cast<size_t>(width) * height)
+   {
+      const auto msg = "Sprite pixel count doesn't match its size. Size is " + std::to_string(width) + "x" + std::to_string(height) + ", pixel count was: " + std::to_string(pixels.size());
+      ::oof::detail::error(msg);
+      return;
+   }
+   if (alpha_mask.size() != pixels.size())
+   {
+      const auto msg = "Sprite alpha mask size doesn't match its pixels. Pixel count is " + std::to_string(pixels.size()) + ", mask size was: " + std::to_string(alpha_mask.size());
+      ::oof::detail::error(msg);
+      return;
+   }
+   m_runs = detail::get_pixel_runs(width, height, alpha_mask);
+}
+
+
+auto oof::sprite::get_width() const -> int
+{
+   return m_width;
+}
+
+
+auto oof::sprite::get_height() const -> int
+{
+   return m_height;
+}
+
+
+oof::bitmap_font::bitmap_font(const int glyph_width, const int glyph_height)
+   : m_glyph_width(glyph_width)
+   , m_glyph_height(glyph_height)
+{
+
+}
+
+
+auto oof::bitmap_font::set_glyph(const wchar_t letter, const std::vector<uint8_t>& mask) -> void
+{
+   if (mask.size() != static_cast<size_t>(m_glyph_width) * m_glyph_height)
+   {
+      const auto msg = "Glyph mask size doesn't match the font. Glyph size is " + std::to_string(m_glyph_width) + "x" + std::to_string(m_glyph_height) + ", mask size was: " + std::to_string(mask.size());
+      ::oof::detail::error(msg);
+      return;
+   }
+   const auto it = std::ranges::lower_bound(m_glyphs, letter, std::less{}, &glyph::m_letter);
+   if (it != m_glyphs.end() && it->m_letter == letter)
+      it->m_runs = detail::get_pixel_runs(m_glyph_width, m_glyph_height, mask);
+   else
+      m_glyphs.insert(it, glyph{ letter, detail::get_pixel_runs(m_glyph_width, m_glyph_height, mask) });
+}
+
+
+auto oof::bitmap_font::has_glyph(const wchar_t letter) const -> bool
+{
+   return this->find_glyph(letter) != nullptr;
+}
+
+
+auto oof::bitmap_font::get_glyph_width() const -> int
+{
+   return m_glyph_width;
+}
+
+
+auto oof::bitmap_font::get_glyph_height() const -> int
+{
+   return m_glyph_height;
+}
+
+
+auto oof::bitmap_font::find_glyph(const wchar_t letter) const -> const glyph*
+{
+   const auto it = std::ranges::lower_bound(m_glyphs, letter, std::less{}, &glyph::m_letter);
+   if (it == m_glyphs.end() || it->m_letter != letter)
+      return nullptr;
+   return &*it;
+}
+
+
+auto oof::get_default_font() -> const bitmap_font&
+{
+   static const bitmap_font font = [] {
+      bitmap_font result(3, 5);
+      std::vector<uint8_t> mask(15);
+      for (const auto& [letter, rows] : detail::default_font_glyphs)
+      {
+         for (size_t i = 0; i < mask.size(); ++i)
+            mask[i] = rows[i] == '#';
+         result.set_glyph(static_cast<wchar_t>(letter), mask);
+         if (letter >= 'A' && letter <= 'Z')
+            result.set_glyph(static_cast<wchar_t>(letter - 'A' + 'a'), mask);
+      }
+      return result;
+   }();
+   return font;
+}
+
+
+oof::pixel_screen::pixel_screen(
+   const int width,
+   const int halfline_height,
+   const int start_column,
+   const int start_halfline,
+   const color& fill_color
+)
+   : pixel_screen(width, halfline_height, start_column, start_halfline, fill_color, pixel_mode::half_block)
+{
+
+}
+
+
+oof::pixel_screen::pixel_screen(
+   const int width,
+   const int halfline_height,
+   const int start_column,
+   const int start_halfline,
+   const color& fill_color,
+   const pixel_mode mode
+)
+   : m_pixels(width * halfline_height, fill_color)
+   , m_fill_color(fill_color)
+   , m_mode(mode)
+   , m_width(width)
+   , m_halfline_height(halfline_height)
+   , m_origin_column(start_column)
+   , m_origin_halfline(start_halfline)
+   , m_fill_row(width, fill_color)
+{
+   if (width <= 0)
+   {
+      const std::string msg = "Width can't be negative";
+      ::oof::detail::error(msg);
+   }
+   if (halfline_height <= 0)
+   {
+      const std::string msg = "Height can't be negative";
+      ::oof::detail::error(msg);
+   }
+   if (m_mode == pixel_mode::sextant && sizeof(wchar_t) < 4)
+   {
+      ::oof::detail::error("Sextant characters don't fit into a 16 bit wchar_t. Using quadrants instead");
+      m_mode = pixel_mode::quadrant;
+   }
+}
+
+
+oof::pixel_screen::pixel_screen(
+   const int width,
+   const int halfline_height,
+   const int start_column,
+   const int start_halfline
+)
+   : pixel_screen(width, halfline_height, start_column, start_halfline, color{})
+{
+
+}
+
+
+oof::pixel_screen::pixel_screen(
+   const int width,
+   const int halfline_height
+)
+   : pixel_screen(width, halfline_height, 0, 0, color{})
+{
+
+}
+
+
+auto oof::pixel_screen::get_screen_ref() -> screen<std::wstring>&
+{
+   return this->get_or_create_screen();
+}
+
+
+auto oof::pixel_screen::get_or_create_screen() const -> screen<std::wstring>&
+{
+   if (m_screen.has_value() == false)
+   {
+      m_screen.emplace(
+         this->get_cell_width(), this->get_line_height(),
+         m_origin_column / this->get_subpixel_width(), m_origin_halfline / this->get_subpixel_height(),
+         detail::get_pixel_background(m_fill_color, m_mode)
+      );
+      m_screen->set_synchronized_output(m_synchronized_output);
+   }
+   return *m_screen;
+}
+
+
+auto oof::pixel_screen::get_subpixel_width() const -> int
+{
+   return m_mode == pixel_mode::half_block ? 1 : 2;
+}
+
+
+auto oof::pixel_screen::get_subpixel_height() const -> int
+{
+   return m_mode == pixel_mode::sextant ? 3 : 2;
+}
+
+
+auto oof::pixel_screen::get_cell_width() const -> int
+{
+   const int subpixel_width = this->get_subpixel_width();
+   const int first_column = m_origin_column / subpixel_width;
+   const int last_column = (m_origin_column - 1 + m_width) / subpixel_width;
+   return last_column - first_column + 1;
+}
+
+
+// Pixels outside of the screen get the fill color
+auto oof::pixel_screen::gather_subpixels(
+   const std::vector<color>& pixels,
+   const int line,
+   const int cell_column,
+   color* const target
+) const -> void
+{
+   const int subpixel_width = this->get_subpixel_width();
+   const int subpixel_height = this->get_subpixel_height();
+   const int first_halfline = line * subpixel_height - m_origin_halfline % subpixel_height;
+   const int first_column = cell_column * subpixel_width - m_origin_column % subpixel_width;
+   for (int y = 0; y < subpixel_height; ++y)
+   {
+      const color* const row = this->get_row_or_fill(pixels, first_halfline + y);
+      for (int x = 0; x < subpixel_width; ++x)
+      {
+         const int column = first_column + x;
+         const bool is_inside = column >= 0 && column < m_width;
+         target[y * subpixel_width + x] = is_inside ? row[column] : m_fill_color;
+      }
+   }
+}
+
+
+auto oof::pixel_screen::get_subcell(const color* const subpixels) const -> cell<std::wstring>
+{
+   const int subpixel_count = this->get_subpixel_width() * this->get_subpixel_height();
+   const detail::subcell_fit fit = detail::get_subcell_fit(subpixels, subpixel_count);
+   return cell<std::wstring>{
+      .m_letter = detail::get_subcell_letter(m_mode, fit.m_mask),
+      .m_format = {
+         .m_fg_color = fit.m_fg_color,
+         .m_bg_color = fit.m_bg_color
+      }
+   };
+}
+
+
+auto oof::pixel_screen::get_row_or_fill(const std::vector<color>& pixels, const int halfline) const -> const color*
+{
+   if (halfline < 0 || halfline >= m_halfline_height)
+      return m_fill_row.data();
+   return pixels.data() + static_cast<ptrdiff_t>(halfline) * m_width;
+}
+
+
+oof::braille_screen::braille_screen(
+   const int width, const int height,
+   const int start_column, const int start_line,
+   const color& dot_color, const color& bg_color
+)
+   : m_width(width)
+   , m_height(height)
+   , m_origin_column(start_column)
+   , m_origin_line(start_line)
+   , m_dot_color(dot_color)
+   , m_bg_color(bg_color)
+   , m_dots(width * height, 0)
+   , m_colors(width * height, dot_color)
+{
+   if (width <= 0)
+   {
+      const std::string msg = "Width can't be negative";
+      ::oof::detail::error(msg);
+   }
+   if (height <= 0)
+   {
+      const std::string msg = "Height can't be negative";
+      ::oof::detail::error(msg);
+   }
+}
+
+
+oof::braille_screen::braille_screen(
+   const int width, const int height,
+   const int start_column, const int start_line
+)
+   : braille_screen(width, height, start_column, start_line, color{ 255, 255, 255 }, color{})
+{
+
+}
+
+
+oof::braille_screen::braille_screen(const int width, const int height)
+   : braille_screen(width, height, 0, 0)
+{
+
+}
+
+
+auto oof::braille_screen::get_width() const -> int
+{
+   return m_width;
+}
+
+
+auto oof::braille_screen::get_height() const -> int
+{
+   return m_height;
+}
+
+
+auto oof::braille_screen::get_dot_width() const -> int
+{
+   return 2 * m_width;
+}
+
+
+auto oof::braille_screen::get_dot_height() const -> int
+{
+   return 4 * m_height;
+}
+
+
+auto oof::braille_screen::is_dot_in(const int x, const int y) const -> bool
+{
+   return x >= 0 && x < this->get_dot_width() && y >= 0 && y < this->get_dot_height();
+}
+
+
+auto oof::braille_screen::set_dot(const int x, const int y) -> void
+{
+   if (this->is_dot_in(x, y) == false)
+      return;
+   m_dots[(y >> 2) * m_width + (x >> 1)] |= detail::braille_dot_bits[y & 3][x & 1];
+}
+
+
+auto oof::braille_screen::set_dot(const int x, const int y, const color& col) -> void
+{
+   if (this->is_dot_in(x, y) == false)
+      return;
+   const int index = (y >> 2) * m_width + (x >> 1);
+   m_dots[index] |= detail::braille_dot_bits[y & 3][x & 1];
+   m_colors[index] = col;
+}
+
+
+auto oof::braille_screen::clear_dot(const int x, const int y) -> void
+{
+   if (this->is_dot_in(x, y) == false)
+      return;
+   m_dots[(y >> 2) * m_width + (x >> 1)] &= ~detail::braille_dot_bits[y & 3][x & 1];
+}
+
+
+auto oof::braille_screen::is_dot_set(const int x, const int y) const -> bool
+{
+   if (this->is_dot_in(x, y) == false)
+      return false;
+   return (m_dots[(y >> 2) * m_width + (x >> 1)] & detail::braille_dot_bits[y & 3][x & 1]) != 0;
+}
+
+
+auto oof::braille_screen::get_color(const int column, const int line) const -> const color&
+{
+   return m_colors[line * m_width + column];
+}
+
+
+auto oof::braille_screen::get_color(const int column, const int line) -> color&
+{
+   return m_colors[line * m_width + column];
+}
+
+
+auto oof::braille_screen::set_synchronized_output(const bool new_value) -> void
+{
+   m_synchronized_output = new_value;
+}
+
+
+auto oof::braille_screen::clear() -> void
+{
+   std::ranges::fill(m_dots, uint8_t{ 0 });
+   std::ranges::fill(m_colors, m_dot_color);
+}
+
+
+// A cell only needs to be written when its dot byte or its color changed
+auto oof::braille_screen::update_sequence_buffer() const -> void
+{
+   detail::draw_state<std::wstring> state{};
+   m_sequence_buffer.clear();
+   if (m_synchronized_output)
+      m_sequence_buffer.push_back(begin_sync_sequence{});
+   m_sequence_buffer.push_back(reset_sequence{});
+
+   const bool has_old_state = m_old_dots.empty() == false;
+   cell<std::wstring> target_cell{ .m_format = {.m_bg_color = m_bg_color } };
+   for (detail::cell_pos relative_pos{ m_width, m_height }; relative_pos.is_end() == false; ++relative_pos)
+   {
+      const int index = relative_pos.m_index;
+      if (has_old_state && m_dots[index] == m_old_dots[index] && m_colors[index] == m_old_colors[index])
+         continue;
+      target_cell.m_letter = static_cast<wchar_t>(0x2800 + m_dots[index]);
+      target_cell.m_format.m_fg_color = m_colors[index];
+      state.write_sequence(
+         m_sequence_buffer,
+         target_cell, std::nullopt,
+         relative_pos,
+         m_origin_line, m_origin_column
+      );
+   }
+   if (m_synchronized_output)
+      m_sequence_buffer.push_back(end_sync_sequence{});
+}
+
+
+auto oof::braille_screen::get_string() const -> std::wstring
+{
+   std::wstring result;
+   this->get_string(result);
+   return result;
+}
+
+
+auto oof::braille_screen::get_string(std::wstring& buffer) const -> void
+{
+   this->update_sequence_buffer();
+
+   // Reserve if the string buffer is still empty (on the first call)
+   if (buffer.empty())
+      buffer.reserve(::oof::get_string_reserve_size(m_sequence_buffer));
+
+   buffer.clear();
+
+   ::oof::detail::write_sequence_string_no_reserve(m_sequence_buffer, buffer);
+   m_old_dots = m_dots;
+   m_old_colors = m_colors;
+}
+
+
+template<oof::std_string_type string_type>
+oof::compositor<string_type>::compositor(
+   const int width, const int height,
+   const int start_column, const int start_line,
+   const cell<string_type>& background
+)
+   : m_width(width)
+   , m_height(height)
+   , m_background(background)
+   , m_dirty_regions{ region{0, 0, width, height} }
+   , m_output(width, height, start_column, start_line, background)
+{
+
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::compositor<string_type>::add_layer(
+   const int column, const int line,
+   const int width, const int height,
+   const int z_order
+) -> int
+{
+   const cell<string_type> transparent_cell{ char_type{}, m_background.m_format };
+   m_layers.push_back(layer{ screen<string_type>(width, height, 0, 0, transparent_cell), column, line, z_order });
+   this->update_draw_order();
+   return static_cast<int>(m_layers.size()) - 1;
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::compositor<string_type>::get_checked_layer(const int layer_id) -> layer&
+{
+   if (layer_id < 0 || layer_id >= static_cast<int>(m_layers.size()))
+   {
+      const auto msg = "Layer id is out of range. Layer count is " + std::to_string(m_layers.size()) + ", id was: " + std::to_string(layer_id);
+      ::oof::detail::error(msg);
+      return m_layers[0];
+   }
+   return m_layers[layer_id];
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::compositor<string_type>::get_layer(const int layer_id) -> screen<string_type>&
+{
+   layer& target = this->get_checked_layer(layer_id);
+   target.m_dirty = true;
+   return target.m_screen;
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::compositor<string_type>::set_layer_position(
+   const int layer_id,
+   const int column, const int line
+) -> void
+{
+   layer& target = this->get_checked_layer(layer_id);
+   if (target.m_visible)
+      m_dirty_regions.push_back(this->get_region(target));
+   target.m_column = column;
+   target.m_line = line;
+   target.m_dirty = true;
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::compositor<string_type>::set_layer_visible(
+   const int layer_id,
+   const bool visible
+) -> void
+{
+   layer& target = this->get_checked_layer(layer_id);
+   if (target.m_visible == visible)
+      return;
+   target.m_visible = visible;
+   m_dirty_regions.push_back(this->get_region(target));
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::compositor<string_type>::set_layer_z_order(
+   const int layer_id,
+   const int z_order
+) -> void
+{
+   layer& target = this->get_checked_layer(layer_id);
+   target.m_z_order = z_order;
+   target.m_dirty = true;
+   this->update_draw_order();
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::compositor<string_type>::set_layer_opacity(
+   const int layer_id,
+   const uint8_t opacity
+) -> void
+{
+   layer& target = this->get_checked_layer(layer_id);
+   target.m_opacity = opacity;
+   target.m_dirty = true;
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::compositor<string_type>::get_width() const -> int
+{
+   return m_width;
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::compositor<string_type>::get_height() const -> int
+{
+   return m_height;
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::compositor<string_type>::get_string() const -> string_type
+{
+   this->composite();
+   return m_output.get_string();
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::compositor<string_type>::get_string(string_type& buffer) const -> void
+{
+   this->composite();
+   m_output.get_string(buffer);
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::compositor<string_type>::set_synchronized_output(const bool new_value) -> void
+{
+   m_output.set_synchronized_output(new_value);
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::compositor<string_type>::get_region(const layer& target) const -> region
+{
+   return region{ target.m_column, target.m_line, target.m_screen.get_width(), target.m_screen.get_height() };
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::compositor<string_type>::update_draw_order() -> void
+{
+   m_draw_order.resize(m_layers.size());
+   for (int i = 0; i < static_cast<int>(m_draw_order.size()); ++i)
+      m_draw_order[i] = i;
+   std::ranges::stable_sort(m_draw_order, std::less{}, [&](const int layer_id) {
+      return m_layers[layer_id].m_z_order;
+   });
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::compositor<string_type>::composite() const -> void
+{
+   for (const layer& candidate : m_layers)
+   {
+      if (candidate.m_dirty && candidate.m_visible)
+         m_dirty_regions.push_back(this->get_region(candidate));
+      candidate.m_dirty = false;
+   }
+   for (const region& dirty_region : m_dirty_regions)
+      this->composite_region(dirty_region);
+   m_dirty_regions.clear();
+}
+
+
+// Every output cell starts as the background and gets the visible layers stacked over it from the bottom up
+template<oof::std_string_type string_type>
+auto oof::compositor<string_type>::composite_region(const region& target_region) const -> void
+{
+   const int first_column = std::max(target_region.m_column, 0);
+   const int end_column = std::min(target_region.m_column + target_region.m_width, m_width);
+   const int first_line = std::max(target_region.m_line, 0);
+   const int end_line = std::min(target_region.m_line + target_region.m_height, m_height);
+   for (int line = first_line; line < end_line; ++line)
+   {
+      for (int column = first_column; column < end_column; ++column)
+      {
+         cell<string_type> result = m_background;
+         for (const int layer_id : m_draw_order)
+         {
+            const layer& source = m_layers[layer_id];
+            const int layer_column = column - source.m_column;
+            const int layer_line = line - source.m_line;
+            if (source.m_visible == false || source.m_screen.is_inside(layer_column, layer_line) == false)
+               continue;
+            const cell<string_type>& source_cell = *(source.m_screen.begin() + layer_line * source.m_screen.get_width() + layer_column);
+            if (source_cell.m_letter == char_type{})
+               continue;
+            if (source.m_opacity == 255)
+            {
+               result = source_cell;
+               continue;
+            }
+            result.m_letter = source_cell.m_letter;
+            result.m_format.m_underline = source_cell.m_format.m_underline;
+            result.m_format.m_bold = source_cell.m_format.m_bold;
+            result.m_format.m_fg_color = detail::get_blended(result.m_format.m_bg_color, source_cell.m_format.m_fg_color, source.m_opacity);
+            result.m_format.m_bg_color = detail::get_blended(result.m_format.m_bg_color, source_cell.m_format.m_bg_color, source.m_opacity);
+         }
+         m_output.get_cell(column, line) = result;
+      }
+   }
+}
+template struct oof::compositor<std::string>;
+template struct oof::compositor<std::wstring>;
+
+
+template<oof::std_string_type string_type>
+oof::viewport<string_type>::viewport(
+   const int canvas_width, const int canvas_height,
+   const int view_width, const int view_height,
+   const int start_column, const int start_line,
+   const cell<string_type>& background
+)
+   : m_canvas(canvas_width, canvas_height, 0, 0, background)
+   , m_view(view_width, view_height, start_column, start_line, background)
+{
+   // Sync and scroll sequences at most. Reserved so that the first scrolling frame doesn't allocate
+   m_sequence_buffer.reserve(4);
+   if (view_width > canvas_width || view_height > canvas_height)
+   {
+      const auto msg = "Viewport can't be bigger than its canvas. Canvas is " + std::to_string(canvas_width) + "x" + std::to_string(canvas_height) + ", view was: " + std::to_string(view_width) + "x" + std::to_string(view_height);
+      ::oof::detail::error(msg);
+   }
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::viewport<string_type>::get_canvas() -> screen<string_type>&
+{
+   return m_canvas;
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::viewport<string_type>::set_offset(const int column, const int line) -> void
+{
+   m_offset_column = std::clamp(column, 0, std::max(m_canvas.get_width() - m_view.get_width(), 0));
+   m_offset_line = std::clamp(line, 0, std::max(m_canvas.get_height() - m_view.get_height(), 0));
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::viewport<string_type>::get_offset_column() const -> int
+{
+   return m_offset_column;
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::viewport<string_type>::get_offset_line() const -> int
+{
+   return m_offset_line;
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::viewport<string_type>::get_view_width() const -> int
+{
+   return m_view.get_width();
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::viewport<string_type>::get_view_height() const -> int
+{
+   return m_view.get_height();
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::viewport<string_type>::set_terminal_scrolling(const bool new_value) -> void
+{
+   m_terminal_scrolling = new_value;
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::viewport<string_type>::set_synchronized_output(const bool new_value) -> void
+{
+   m_synchronized_output = new_value;
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::viewport<string_type>::get_string() const -> string_type
+{
+   string_type result;
+   this->get_string(result);
+   return result;
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::viewport<string_type>::get_string(string_type& buffer) const -> void
+{
+   m_sequence_buffer.clear();
+   if (m_synchronized_output)
+      m_sequence_buffer.push_back(begin_sync_sequence{});
+
+   this->update_view();
+
+   // The terminal moves the lines that are still visible, so the old state of the view is moved the same way
+   const int view_height = m_view.get_height();
+   if (m_terminal_scrolling && m_displayed_offset_line.has_value() && m_view.m_old_cells.empty() == false)
+   {
+      const int scroll_amount = m_offset_line - m_displayed_offset_line.value();
+      if (scroll_amount != 0 && std::abs(scroll_amount) < view_height)
+      {
+         m_sequence_buffer.push_back(scroll_region(m_view.m_origin_line, m_view.m_origin_line + view_height - 1));
+         if (scroll_amount > 0)
+            m_sequence_buffer.push_back(scroll_up(scroll_amount));
+         else
+            m_sequence_buffer.push_back(scroll_down(-scroll_amount));
+         m_sequence_buffer.push_back(reset_scroll_region());
+         m_view.shift_old_lines(scroll_amount);
+      }
+   }
+   m_displayed_offset_line = m_offset_line;
+   m_view.get_string(m_frame_buffer);
+
+   if (buffer.empty())
+      buffer.reserve(::oof::get_string_reserve_size(m_sequence_buffer) + m_frame_buffer.size() + 8);
+   buffer.clear();
+   ::oof::detail::write_sequence_string_no_reserve(m_sequence_buffer, buffer);
+   buffer += m_frame_buffer;
+   if (m_synchronized_output)
+      write_sequence_into_string(buffer, end_sync());
+}
+
+
+// Copies the visible part of the canvas into the view, one row at a time
+template<oof::std_string_type string_type>
+auto oof::viewport<string_type>::update_view() const -> void
+{
+   const int view_width = m_view.get_width();
+   for (int line = 0; line < m_view.get_height(); ++line)
+   {
+      const auto source_begin = m_canvas.begin() + (m_offset_line + line) * m_canvas.get_width() + m_offset_column;
+      std::copy(source_begin, source_begin + view_width, m_view.m_cells.begin() + line * view_width);
+   }
+}
+template struct oof::viewport<std::string>;
+template struct oof::viewport<std::wstring>;
+
+
+template<typename canvas_type>
+oof::presenter<canvas_type>::presenter(
+   const canvas_type& canvas,
+   write_callback_type write_callback,
+   const int buffer_count,
+   const present_policy policy
+)
+   : m_canvas(canvas)
+   , m_output_canvas(canvas)
+   , m_write_callback(std::move(write_callback))
+   , m_max_waiting_frames(static_cast<size_t>(std::max(buffer_count, 2) - 1))
+   , m_policy(policy)
+{
+   if (buffer_count < 2)
+      ::oof::detail::error("Presenter needs at least 2 buffers");
+   m_output_thread = std::jthread([this] { this->output_loop(); });
+}
+
+
+template<typename canvas_type>
+oof::presenter<canvas_type>::~presenter()
+{
+   {
+      std::scoped_lock lock(m_mutex);
+      m_stop = true;
+   }
+   m_condition.notify_all();
+}
+
+
+template<typename canvas_type>
+auto oof::presenter<canvas_type>::get_canvas() -> canvas_type&
+{
+   return m_canvas;
+}
+
+
+template<typename canvas_type>
+auto oof::presenter<canvas_type>::present() -> void
+{
+   std::vector<element_type> frame;
+   {
+      std::scoped_lock lock(m_mutex);
+      if (m_free_frames.empty() == false)
+      {
+         frame = std::move(m_free_frames.back());
+         m_free_frames.pop_back();
+      }
+   }
+   frame.assign(std::ranges::begin(m_canvas), std::ranges::end(m_canvas));
+
+   std::unique_lock lock(m_mutex);
+   if (m_waiting_frames.size() >= m_max_waiting_frames)
+   {
+      if (m_policy == present_policy::block)
+      {
+         m_condition.wait(lock, [&] { return m_waiting_frames.size() < m_max_waiting_frames; });
+      }
+      else
+      {
+         m_free_frames.push_back(std::move(m_waiting_frames.front()));
+         m_waiting_frames.pop_front();
+         ++m_stats.m_dropped_frames;
+      }
+   }
+   m_waiting_frames.push_back(std::move(frame));
+   lock.unlock();
+   m_condition.notify_all();
+}
+
+
+template<typename canvas_type>
+auto oof::presenter<canvas_type>::wait_until_written() -> void
+{
+   std::unique_lock lock(m_mutex);
+   m_condition.wait(lock, [&] { return m_waiting_frames.empty() && m_is_writing == false; });
+}
+
+
+template<typename canvas_type>
+auto oof::presenter<canvas_type>::get_stats() const -> presenter_stats
+{
+   std::scoped_lock lock(m_mutex);
+   return m_stats;
+}
+
+
+// Frames are copied into a single output canvas. That way, the diff is always against the frame that was written last
+template<typename canvas_type>
+auto oof::presenter<canvas_type>::output_loop() -> void
+{
+   string_type string_buffer;
+   while (true)
+   {
+      std::vector<element_type> frame;
+      {
+         std::unique_lock lock(m_mutex);
+         m_condition.wait(lock, [&] { return m_stop || m_waiting_frames.empty() == false; });
+         if (m_waiting_frames.empty())
+            return;
+         frame = std::move(m_waiting_frames.front());
+         m_waiting_frames.pop_front();
+         m_is_writing = true;
+      }
+      m_condition.notify_all();
+
+      std::ranges::copy(frame, std::ranges::begin(m_output_canvas));
+      const auto t0 = std::chrono::steady_clock::now();
+      m_output_canvas.get_string(string_buffer);
+      m_write_callback(string_buffer);
+      const auto latency = std::chrono::steady_clock::now() - t0;
+
+      {
+         std::scoped_lock lock(m_mutex);
+         m_free_frames.push_back(std::move(frame));
+         m_is_writing = false;
+         m_stats.m_last_latency = std::chrono::duration_cast<std::chrono::nanoseconds>(latency);
+         m_stats.m_max_latency = std::max(m_stats.m_max_latency, m_stats.m_last_latency);
+         ++m_stats.m_written_frames;
+      }
+      m_condition.notify_all();
+   }
+}
+template struct oof::presenter<oof::screen<std::string>>;
+template struct oof::presenter<oof::screen<std::wstring>>;
+template struct oof::presenter<oof::pixel_screen>;
+
+
+auto oof::pixel_screen::set_synchronized_output(const bool new_value) -> void
+{
+   m_synchronized_output = new_value;
+   if (m_screen.has_value())
+      m_screen->set_synchronized_output(new_value);
+}
+
+
+auto oof::pixel_screen::get_sequences() const -> const std::vector<sequence_variant_type>&
+{
+   if (m_screen.has_value())
+      return m_screen->get_sequences();
+   return m_sequence_buffer;
+}
+
+
+#ifdef OOF_RENDER_STATS
+auto oof::pixel_screen::get_render_stats() const -> const render_stats&
+{
+   if (m_screen.has_value())
+      return m_screen->get_render_stats();
+   return m_render_stats;
+}
+#endif
+
+
+// With an odd origin, the first line only has its lower half inside the pixels. So the pixel rows are shifted by one
+auto oof::pixel_screen::compute_result() const -> void
+{
+   screen<std::wstring>& target_screen = this->get_or_create_screen();
+   if (m_mode != pixel_mode::half_block)
+   {
+      std::array<color, 6> subpixels;
+      auto target_cell = target_screen.begin();
+      for (int line = 0; line < target_screen.get_height(); ++line)
+      {
+         for (int cell_column = 0; cell_column < target_screen.get_width(); ++cell_column)
+         {
+            this->gather_subpixels(m_pixels, line, cell_column, subpixels.data());
+            *target_cell = this->get_subcell(subpixels.data());
+            ++target_cell;
+         }
+      }
+      return;
+   }
+
+   const int halfline_offset = (m_origin_halfline % 2 == 0) ? 0 : -1;
+   cell<std::wstring>* target_line = std::to_address(target_screen.begin());
+   for (int line = 0; line < target_screen.get_height(); ++line)
+   {
+      const int halfline_top = 2 * line + halfline_offset;
+      detail::write_pixel_line(
+         target_line,
+         this->get_row_or_fill(m_pixels, halfline_top), this->get_row_or_fill(m_pixels, halfline_top + 1),
+         m_width
+      );
+      target_line += m_width;
+   }
+}
+
+
+// Diffs the pixels against the ones from the last call and writes the changed cells without any intermediate screen.
+// The result is identical to going through the screen.
+auto oof::pixel_screen::update_sequence_buffer() const -> void
+{
+   detail::draw_state<std::wstring> state{};
+   m_sequence_buffer.clear();
+   if (m_synchronized_output)
+      m_sequence_buffer.push_back(begin_sync_sequence{});
+   m_sequence_buffer.push_back(reset_sequence{});
+
+   const bool has_old_pixels = m_old_pixels.empty() == false;
+   const int line_height = this->get_line_height();
+   const int cell_width = this->get_cell_width();
+   const int origin_line = m_origin_halfline / this->get_subpixel_height();
+   const int origin_column = m_origin_column / this->get_subpixel_width();
+   detail::cell_pos relative_pos{ cell_width, line_height };
+
+   if (m_mode != pixel_mode::half_block)
+   {
+      const int subpixel_count = this->get_subpixel_width() * this->get_subpixel_height();
+      std::array<color, 6> subpixels;
+      std::array<color, 6> old_subpixels;
+      for (int line = 0; line < line_height; ++line)
+      {
+         for (int cell_column = 0; cell_column < cell_width; ++cell_column)
+         {
+            this->gather_subpixels(m_pixels, line, cell_column, subpixels.data());
+            if (has_old_pixels)
+            {
+               this->gather_subpixels(m_old_pixels, line, cell_column, old_subpixels.data());
+               if (std::equal(subpixels.data(), subpixels.data() + subpixel_count, old_subpixels.data()))
+                  continue;
+            }
+
+            // Different pixels can still result in the same cell
+            const cell<std::wstring> target_cell = this->get_subcell(subpixels.data());
+            if (has_old_pixels && target_cell == this->get_subcell(old_subpixels.data()))
+               continue;
+            relative_pos.set_position(cell_column, line);
+            state.write_sequence(
+               m_sequence_buffer,
+               target_cell, std::nullopt,
+               relative_pos,
+               origin_line, origin_column
+            );
+         }
+      }
+   }
+   else
+   {
+      const int halfline_offset = (m_origin_halfline % 2 == 0) ? 0 : -1;
+      cell<std::wstring> target_cell = detail::get_pixel_background(m_fill_color, m_mode);
+      for (int line = 0; line < line_height; ++line)
+      {
+         const int halfline_top = 2 * line + halfline_offset;
+         const color* const top_row = this->get_row_or_fill(m_pixels, halfline_top);
+         const color* const bottom_row = this->get_row_or_fill(m_pixels, halfline_top + 1);
+         const color* const old_top_row = has_old_pixels ? this->get_row_or_fill(m_old_pixels, halfline_top) : nullptr;
+         const color* const old_bottom_row = has_old_pixels ? this->get_row_or_fill(m_old_pixels, halfline_top + 1) : nullptr;
+         for (int column = 0; column < m_width; ++column)
+         {
+            if (has_old_pixels && top_row[column] == old_top_row[column] && bottom_row[column] == old_bottom_row[column])
+               continue;
+            target_cell.m_format.m_fg_color = top_row[column];
+            target_cell.m_format.m_bg_color = bottom_row[column];
+            relative_pos.set_position(column, line);
+            state.write_sequence(
+               m_sequence_buffer,
+               target_cell, std::nullopt,
+               relative_pos,
+               origin_line, origin_column
+            );
+         }
+      }
+   }
+   if (m_synchronized_output)
+      m_sequence_buffer.push_back(end_sync_sequence{});
+}
+
+
+auto oof::pixel_screen::get_string() const -> std::wstring
+{
+   std::wstring result;
+   this->get_string(result);
+   return result;
+}
+
+
+auto oof::pixel_screen::get_string(std::wstring& buffer) const -> void
+{
+   if (m_screen.has_value())
+   {
+      compute_result();
+      m_screen->get_string(buffer);
+      return;
+   }
+
+#ifdef OOF_RENDER_STATS
+   detail::stats_recorder recorder{ m_render_stats, buffer.capacity(), m_sequence_buffer.capacity() };
+#endif
+   this->update_sequence_buffer();
+#ifdef OOF_RENDER_STATS
+   recorder.end_diff();
+#endif
+
+   // Reserve if the string buffer is still empty (on the first call)
+   if (buffer.empty())
+      buffer.reserve(::oof::get_string_reserve_size(m_sequence_buffer));
+
+   buffer.clear();
+
+   ::oof::detail::write_sequence_string_no_reserve(m_sequence_buffer, buffer);
+   m_old_pixels = m_pixels;
+#ifdef OOF_RENDER_STATS
+   recorder.finish(m_sequence_buffer, this->get_cell_width() * this->get_line_height(), buffer.size(), buffer.capacity());
+#endif
+}
+
+
+// Byte budgets need the per-cell bookkeeping of the screen
+auto oof::pixel_screen::get_string(std::wstring& buffer, const size_t byte_budget) const -> void
+{
+   compute_result();
+   m_screen->get_string(buffer, byte_budget);
+}
+
+
+auto oof::pixel_screen::get_line_height() const -> int
+{
+   const int subpixel_height = this->get_subpixel_height();
+   const int first_line = m_origin_halfline / subpixel_height;
+   const int last_line = (m_origin_halfline - 1 + m_halfline_height) / subpixel_height;
+   return last_line - first_line + 1;
+}
+
+
+auto oof::pixel_screen::is_in(const int column, const int halfline) const -> bool
+{
+   return column >= 0 && column < m_width && halfline >= 0 && halfline < m_halfline_height;
+}
+
+
+auto oof::pixel_screen::get_color(
+   const int column,
+   const int halfline
+) const -> const color&
+{
+   return m_pixels[this->get_checked_index(column, halfline)];
+}
+
+
+auto oof::pixel_screen::get_color(
+   const int column,
+   const int halfline
+) -> color&
 {
+   return m_pixels[this->get_checked_index(column, halfline)];
+}
 
+
+// Returns 0 for coordinates that are out of range, after reporting them
+auto oof::pixel_screen::get_checked_index(const int column, const int halfline) const -> size_t
+{
+   if (halfline < 0 || halfline >= m_halfline_height)
+   {
+      std::string msg = "Halfline is out of range. Height is ";
+      msg += std::to_string(m_halfline_height);
+      msg += ", halfline was: ";
+      msg += std::to_string(halfline);
+      ::oof::detail::error(msg);
+      return 0;
+   }
+   if (column < 0 || column >= m_width)
+   {
+      std::string msg = "Column is out of range. Width is ";
+      msg += std::to_string(m_width);
+      msg += ", column was: ";
+      msg += std::to_string(column);
+      ::oof::detail::error(msg);
+      return 0;
+   }
+   return static_cast<size_t>(halfline) * m_width + column;
 }
 
 
-oof::pixel_screen::pixel_screen(
-   const int width,
-   const int halfline_height,
-   const int start_column,
-   const int start_halfline
-)
-   : pixel_screen(width, halfline_height, start_column, start_halfline, color{})
+auto oof::pixel_screen::get_color_unchecked(
+   const int column,
+   const int halfline
+) const -> const color&
 {
+   return m_pixels[halfline * m_width + column];
+}
 
+
+auto oof::pixel_screen::get_color_unchecked(
+   const int column,
+   const int halfline
+) -> color&
+{
+   return m_pixels[halfline * m_width + column];
 }
 
 
-oof::pixel_screen::pixel_screen(
-   const int width,
-   const int halfline_height
-)
-   : pixel_screen(width, halfline_height, 0, 0, color{})
+auto oof::pixel_screen::get_row(const int halfline) const -> std::span<const color>
 {
+   if (halfline < 0 || halfline >= m_halfline_height)
+      return {};
+   return std::span<const color>(m_pixels).subspan(static_cast<size_t>(halfline) * m_width, m_width);
+}
+
 
+auto oof::pixel_screen::get_row(const int halfline) -> std::span<color>
+{
+   if (halfline < 0 || halfline >= m_halfline_height)
+      return {};
+   return std::span<color>(m_pixels).subspan(static_cast<size_t>(halfline) * m_width, m_width);
 }
 
 
-auto oof::pixel_screen::get_screen_ref() -> screen<std::wstring>&
+auto oof::pixel_screen::get_raster_view() -> detail::raster_view<color>
 {
-   return m_screen;
+   return detail::raster_view<color>{ m_pixels.data(), m_width, m_halfline_height };
 }
 
 
-auto oof::pixel_screen::compute_result() const -> void
+auto oof::pixel_screen::draw_hline(const int column, const int halfline, const int length, const color& col) -> void
 {
-   int halfline_top = (m_origin_halfline % 2 == 0) ? 0 : -1;
-   int halfline_bottom = halfline_top + 1;
-   // TODO iterator?
-   for (int line = 0; line < m_screen.get_height(); ++line) {
-      for (int column = 0; column < m_screen.get_width(); ++column) {
-         cell<std::wstring>& target_cell = m_screen.get_cell(column, line);
-         target_cell.m_format.m_fg_color = is_in(column, halfline_top) ? get_color(column, halfline_top) : m_fill_color;
-         target_cell.m_format.m_bg_color = is_in(column, halfline_bottom) ? get_color(column, halfline_bottom) : m_fill_color;
-      }
-      halfline_top += 2;
-      halfline_bottom += 2;
-   }
+   detail::fill_rect(this->get_raster_view(), column, halfline, length, 1, col);
 }
 
 
-auto oof::pixel_screen::get_string() const -> std::wstring
+auto oof::pixel_screen::draw_vline(const int column, const int halfline, const int length, const color& col) -> void
 {
-   compute_result();
-   return m_screen.get_string();
+   detail::fill_rect(this->get_raster_view(), column, halfline, 1, length, col);
 }
 
 
-auto oof::pixel_screen::get_string(std::wstring& buffer) const -> void
+auto oof::pixel_screen::fill_rect(
+   const int column, const int halfline,
+   const int width, const int height,
+   const color& col
+) -> void
 {
-   compute_result();
-   m_screen.get_string(buffer);
+   detail::fill_rect(this->get_raster_view(), column, halfline, width, height, col);
 }
 
 
-auto oof::pixel_screen::get_line_height() const -> int
+auto oof::pixel_screen::draw_rect(
+   const int column, const int halfline,
+   const int width, const int height,
+   const color& col
+) -> void
 {
-   const int first_line = m_origin_halfline / 2;
-   const int last_line = (m_origin_halfline - 1 + m_halfline_height) / 2;
-   return last_line - first_line + 1;
+   detail::draw_rect(this->get_raster_view(), column, halfline, width, height, col);
 }
 
 
-auto oof::pixel_screen::is_in(const int column, const int halfline) const -> bool
+auto oof::pixel_screen::draw_line(
+   const int column0, const int halfline0,
+   const int column1, const int halfline1,
+   const color& col
+) -> void
 {
-   const size_t index = halfline * this->get_width() + column;
-   return index >= 0 && index < m_pixels.size();
+   detail::draw_line(this->get_raster_view(), column0, halfline0, column1, halfline1, col);
 }
 
 
-auto oof::pixel_screen::get_color(
-   const int column,
-   const int halfline
-) const -> const color&
+auto oof::pixel_screen::draw_circle(
+   const int center_column, const int center_halfline,
+   const int radius,
+   const color& col
+) -> void
 {
-   const size_t index = halfline * this->get_width() + column;
-   return m_pixels[index];
+   detail::draw_circle(this->get_raster_view(), center_column, center_halfline, radius, col);
 }
 
 
-auto oof::pixel_screen::get_color(
-   const int column,
-   const int halfline
-) -> color&
+auto oof::pixel_screen::fill_circle(
+   const int center_column, const int center_halfline,
+   const int radius,
+   const color& col
+) -> void
+{
+   detail::fill_circle(this->get_raster_view(), center_column, center_halfline, radius, col);
+}
+
+
+auto oof::pixel_screen::blend_rect(
+   const int column, const int halfline,
+   const int width, const int height,
+   const color& col,
+   const uint8_t alpha
+) -> void
+{
+   detail::blend_rect(this->get_raster_view(), column, halfline, width, height, col, alpha);
+}
+
+
+auto oof::pixel_screen::blit(
+   const int column, const int halfline,
+   const std::span<const color> source,
+   const int source_width
+) -> void
+{
+   detail::blit(this->get_raster_view(), column, halfline, source, source_width);
+}
+
+
+// The visible rectangle is computed once, runs are only cut to it
+auto oof::pixel_screen::draw_sprite(const sprite& source, const int column, const int halfline) -> void
+{
+   const int first_column = std::max(column, 0);
+   const int end_column = std::min(column + source.m_width, m_width);
+   const int first_halfline = std::max(halfline, 0);
+   const int end_halfline = std::min(halfline + source.m_height, m_halfline_height);
+   if (first_column >= end_column || first_halfline >= end_halfline)
+      return;
+   for (const detail::pixel_run& run : source.m_runs)
+   {
+      const int target_halfline = halfline + run.m_row;
+      if (target_halfline < first_halfline || target_halfline >= end_halfline)
+         continue;
+      const int run_begin = std::max(column + run.m_column, first_column);
+      const int run_end = std::min(column + run.m_column + run.m_length, end_column);
+      if (run_begin >= run_end)
+         continue;
+      const color* const source_begin = source.m_pixels.data() + run.m_row * source.m_width + (run_begin - column);
+      std::copy(source_begin, source_begin + (run_end - run_begin), m_pixels.data() + static_cast<size_t>(target_halfline) * m_width + run_begin);
+   }
+}
+
+
+auto oof::pixel_screen::draw_text(
+   const bitmap_font& font,
+   const std::wstring& text,
+   const int column, const int halfline,
+   const color& col,
+   const int scale
+) -> void
 {
-   const size_t index = halfline * this->get_width() + column;
-   return m_pixels[index];
+   if (scale < 1)
+   {
+      const auto msg = "Text scale must be at least 1. Scale was: " + std::to_string(scale);
+      ::oof::detail::error(msg);
+      return;
+   }
+   const detail::raster_view<color> view = this->get_raster_view();
+   int glyph_column = column;
+   int glyph_halfline = halfline;
+   for (const wchar_t letter : text)
+   {
+      if (letter == L'\n')
+      {
+         glyph_column = column;
+         glyph_halfline += (font.m_glyph_height + 1) * scale;
+         continue;
+      }
+      if (const bitmap_font::glyph* const found = font.find_glyph(letter); found != nullptr)
+      {
+         for (const detail::pixel_run& run : found->m_runs)
+         {
+            detail::fill_rect(
+               view,
+               glyph_column + run.m_column * scale, glyph_halfline + run.m_row * scale,
+               run.m_length * scale, scale,
+               col
+            );
+         }
+      }
+      glyph_column += (font.m_glyph_width + 1) * scale;
+   }
 }
 
 
 auto oof::pixel_screen::get_width() const -> int
 {
-   return m_screen.get_width();
+   return m_width;
 }
 
 
@@ -1214,8 +4684,8 @@ auto oof::detail::draw_state<string_type>::write_sequence(
    if (this->is_position_sequence_necessary(target_pos)) {
       sequence_buffer.push_back(
          position_sequence{
-            .m_line = static_cast<uint8_t>(target_pos.get_line() + origin_line),
-            .m_column = static_cast<uint8_t>(target_pos.get_column() + origin_column)
+            .m_line = static_cast<uint16_t>(target_pos.get_line() + origin_line),
+            .m_column = static_cast<uint16_t>(target_pos.get_column() + origin_column)
          }
       );
    }
@@ -1236,15 +4706,13 @@ auto oof::detail::draw_state<string_type>::is_position_sequence_necessary(
    if (m_last_written_pos.has_value() == false)
       return true;
 
-   const cell_pos current_cursor_pos = m_last_written_pos.value() + 1;
-
    // The cursor position is known to be wrong
-   if (target_pos != current_cursor_pos)
+   if (target_pos.m_index != m_last_written_pos->m_index + 1)
       return true;
 
    // If we're on the "right" position according to the subset of the buffer, the position still
    // needs to be set if there was a line jump.
-   if (current_cursor_pos.get_line() != m_last_written_pos->get_line())
+   if (target_pos.get_line() != m_last_written_pos->get_line())
       return true;
 
    return false;
@@ -1269,10 +4737,25 @@ auto oof::detail::error(const std::string& msg) -> void
 }
 
 
-auto oof::detail::get_pixel_background(const color& fill_color) -> cell<std::wstring>
+auto oof::detail::write_pixel_line(
+   cell<std::wstring>* const target,
+   const color* const top_row,
+   const color* const bottom_row,
+   const int width
+) -> void
+{
+   for (int column = 0; column < width; ++column)
+   {
+      target[column].m_format.m_fg_color = top_row[column];
+      target[column].m_format.m_bg_color = bottom_row[column];
+   }
+}
+
+
+auto oof::detail::get_pixel_background(const color& fill_color, const pixel_mode mode) -> cell<std::wstring>
 {
    return cell<std::wstring>{
-      .m_letter = L'▀',
+      .m_letter = mode == pixel_mode::half_block ? L'▀' : L' ',
       .m_format = {
          .m_fg_color = fill_color,
          .m_bg_color = fill_color
@@ -1281,6 +4764,413 @@ auto oof::detail::get_pixel_background(const color& fill_color) -> cell<std::wst
 }
 
 
+// Splits the pixels at the middle of the color channel with the biggest range. That's exact for cells with two
+// colors, which is the common case for plots. The cell colors are the averages of both groups.
+auto oof::detail::get_subcell_fit(const color* const subpixels, const int count) -> subcell_fit
+{
+   std::array<int, 3> min_values{ 255, 255, 255 };
+   std::array<int, 3> max_values{ 0, 0, 0 };
+   for (int i = 0; i < count; ++i)
+   {
+      const std::array<int, 3> components{ subpixels[i].red, subpixels[i].green, subpixels[i].blue };
+      for (int channel = 0; channel < 3; ++channel)
+      {
+         min_values[channel] = std::min(min_values[channel], components[channel]);
+         max_values[channel] = std::max(max_values[channel], components[channel]);
+      }
+   }
+   int split_channel = 0;
+   for (int channel = 1; channel < 3; ++channel)
+   {
+      if (max_values[channel] - min_values[channel] > max_values[split_channel] - min_values[split_channel])
+         split_channel = channel;
+   }
+   if (max_values[split_channel] == min_values[split_channel])
+      return subcell_fit{ .m_mask = 0, .m_fg_color = subpixels[0], .m_bg_color = subpixels[0] };
+
+   const int threshold = (min_values[split_channel] + max_values[split_channel]) / 2;
+   std::array<int, 3> fg_sum{};
+   std::array<int, 3> bg_sum{};
+   int fg_count = 0;
+   int mask = 0;
+   for (int i = 0; i < count; ++i)
+   {
+      const std::array<int, 3> components{ subpixels[i].red, subpixels[i].green, subpixels[i].blue };
+      const bool is_fg = components[split_channel] > threshold;
+      std::array<int, 3>& sum = is_fg ? fg_sum : bg_sum;
+      for (int channel = 0; channel < 3; ++channel)
+         sum[channel] += components[channel];
+      if (is_fg)
+      {
+         mask |= 1 << i;
+         ++fg_count;
+      }
+   }
+   const int bg_count = count - fg_count;
+   return subcell_fit{
+      .m_mask = mask,
+      .m_fg_color = color{ fg_sum[0] / fg_count, fg_sum[1] / fg_count, fg_sum[2] / fg_count },
+      .m_bg_color = color{ bg_sum[0] / bg_count, bg_sum[1] / bg_count, bg_sum[2] / bg_count }
+   };
+}
+
+
+auto oof::detail::get_subcell_letter(const pixel_mode mode, const int mask) -> wchar_t
+{
+   // Bits: top left, top right, bottom left, bottom right
+   constexpr std::array<wchar_t, 16> quadrant_letters{
+      L' ', L'▘', L'▝', L'▀', L'▖', L'▌', L'▞', L'▛', L'▗', L'▚', L'▐', L'▜', L'▄', L'▙', L'▟', L'█'
+   };
+   if (mode == pixel_mode::quadrant)
+      return quadrant_letters[mask];
+
+   // Bits: top left, top right, middle left, middle right, bottom left, bottom right. The sextant block starts at
+   // U+1FB00 and counts up in that order, but skips the masks that already exist as block elements.
+   constexpr int left_half_mask = 0b010101;
+   constexpr int right_half_mask = 0b101010;
+   constexpr int full_mask = 0b111111;
+   if (mask == 0)               return L' ';
+   if (mask == left_half_mask)  return L'▌';
+   if (mask == right_half_mask) return L'▐';
+   if (mask == full_mask)       return L'█';
+   const int skipped = (mask > left_half_mask ? 1 : 0) + (mask > right_half_mask ? 1 : 0);
+   return static_cast<wchar_t>(0x1FB00 + mask - 1 - skipped);
+}
+
+
+// Clipping happens once for the whole rectangle, after that it's plain row fills
+template<typename T>
+auto oof::detail::fill_rect(
+   const raster_view<T>& view,
+   const int column, const int row,
+   const int width, const int height,
+   const T& value
+) -> void
+{
+   const int first_column = std::max(column, 0);
+   const int end_column = std::min(column + width, view.m_width);
+   const int first_row = std::max(row, 0);
+   const int end_row = std::min(row + height, view.m_height);
+   if (first_column >= end_column || first_row >= end_row)
+      return;
+   for (int y = first_row; y < end_row; ++y)
+   {
+      T* const row_begin = view.m_data + static_cast<ptrdiff_t>(y) * view.m_width;
+      std::fill(row_begin + first_column, row_begin + end_column, value);
+   }
+}
+
+
+template<typename T>
+auto oof::detail::draw_rect(
+   const raster_view<T>& view,
+   const int column, const int row,
+   const int width, const int height,
+   const T& value
+) -> void
+{
+   if (width <= 0 || height <= 0)
+      return;
+   fill_rect(view, column, row, width, 1, value);
+   fill_rect(view, column, row + height - 1, width, 1, value);
+   fill_rect(view, column, row + 1, 1, height - 2, value);
+   fill_rect(view, column + width - 1, row + 1, 1, height - 2, value);
+}
+
+
+// Bresenham. Lines that are completely on one side of the view are rejected up front
+template<typename T>
+auto oof::detail::draw_line(
+   const raster_view<T>& view,
+   int column0, int row0,
+   const int column1, const int row1,
+   const T& value
+) -> void
+{
+   if (std::max(column0, column1) < 0 || std::min(column0, column1) >= view.m_width)
+      return;
+   if (std::max(row0, row1) < 0 || std::min(row0, row1) >= view.m_height)
+      return;
+
+   const int delta_column = std::abs(column1 - column0);
+   const int delta_row = -std::abs(row1 - row0);
+   const int step_column = column0 < column1 ? 1 : -1;
+   const int step_row = row0 < row1 ? 1 : -1;
+   int error = delta_column + delta_row;
+   while (true)
+   {
+      if (view.is_inside(column0, row0))
+         view.m_data[row0 * view.m_width + column0] = value;
+      if (column0 == column1 && row0 == row1)
+         break;
+      const int doubled_error = 2 * error;
+      if (doubled_error >= delta_row)
+      {
+         error += delta_row;
+         column0 += step_column;
+      }
+      if (doubled_error <= delta_column)
+      {
+         error += delta_column;
+         row0 += step_row;
+      }
+   }
+}
+
+
+// Midpoint circle algorithm, one octant is mirrored into the other seven
+template<typename T>
+auto oof::detail::draw_circle(
+   const raster_view<T>& view,
+   const int center_column, const int center_row,
+   const int radius,
+   const T& value
+) -> void
+{
+   if (radius < 0)
+      return;
+   const auto plot = [&](const int column, const int row) {
+      if (view.is_inside(column, row))
+         view.m_data[row * view.m_width + column] = value;
+   };
+   int x = radius;
+   int y = 0;
+   int error = 1 - radius;
+   while (x >= y)
+   {
+      plot(center_column + x, center_row + y);
+      plot(center_column + y, center_row + x);
+      plot(center_column - y, center_row + x);
+      plot(center_column - x, center_row + y);
+      plot(center_column - x, center_row - y);
+      plot(center_column - y, center_row - x);
+      plot(center_column + y, center_row - x);
+      plot(center_column + x, center_row - y);
+      ++y;
+      if (error < 0)
+      {
+         error += 2 * y + 1;
+      }
+      else
+      {
+         --x;
+         error += 2 * (y - x) + 1;
+      }
+   }
+}
+
+
+// Every row of the circle is one clipped span
+template<typename T>
+auto oof::detail::fill_circle(
+   const raster_view<T>& view,
+   const int center_column, const int center_row,
+   const int radius,
+   const T& value
+) -> void
+{
+   if (radius < 0)
+      return;
+   int half_width = radius;
+   for (int y = 0; y <= radius; ++y)
+   {
+      while (half_width * half_width + y * y > radius * radius)
+         --half_width;
+      fill_rect(view, center_column - half_width, center_row + y, 2 * half_width + 1, 1, value);
+      if (y != 0)
+         fill_rect(view, center_column - half_width, center_row - y, 2 * half_width + 1, 1, value);
+   }
+}
+
+
+template<typename T>
+auto oof::detail::blit(
+   const raster_view<T>& view,
+   const int column, const int row,
+   const std::span<const T> source,
+   const int source_width
+) -> void
+{
+   if (source_width <= 0)
+      return;
+   const int source_height = static_cast<int>(source.size()) / source_width;
+   const int first_column = std::max(column, 0);
+   const int end_column = std::min(column + source_width, view.m_width);
+   const int first_row = std::max(row, 0);
+   const int end_row = std::min(row + source_height, view.m_height);
+   if (first_column >= end_column || first_row >= end_row)
+      return;
+   for (int y = first_row; y < end_row; ++y)
+   {
+      const T* const source_begin = source.data() + static_cast<ptrdiff_t>(y - row) * source_width + (first_column - column);
+      std::copy(source_begin, source_begin + (end_column - first_column), view.m_data + static_cast<ptrdiff_t>(y) * view.m_width + first_column);
+   }
+}
+
+
+#ifdef OOF_RENDER_STATS
+auto oof::detail::stats_recorder::end_diff() -> void
+{
+   m_diff_end = clock_type::now();
+}
+
+
+auto oof::detail::stats_recorder::finish(
+   const std::vector<sequence_variant_type>& sequences,
+   const int cells_scanned,
+   const size_t output_size,
+   const size_t buffer_capacity
+) -> void
+{
+   const clock_type::time_point end = clock_type::now();
+   m_stats = render_stats{};
+   m_stats.m_cells_scanned = cells_scanned;
+   m_stats.m_output_size = output_size;
+   m_stats.m_reallocations = (buffer_capacity != m_buffer_capacity) + (sequences.capacity() != m_sequence_capacity);
+   m_stats.m_diff_time = m_diff_end - m_start;
+   m_stats.m_serialization_time = end - m_diff_end;
+
+   // Every written cell is exactly one letter sequence
+   for (const sequence_variant_type& sequence : sequences)
+   {
+      std::visit([&]<typename sequence_type>(const sequence_type&) {
+         if constexpr (is_any_of<sequence_type, char_sequence, wchar_sequence>)
+            ++m_stats.m_cells_changed;
+         else if constexpr (is_any_of<sequence_type, position_sequence, hposition_sequence, vposition_sequence, move_left_sequence, move_right_sequence, move_up_sequence, move_down_sequence>)
+            ++m_stats.m_cursor_jumps;
+         else if constexpr (is_any_of<sequence_type, fg_rgb_color_sequence, fg_index_color_sequence>)
+            ++m_stats.m_fg_color_sequences;
+         else if constexpr (is_any_of<sequence_type, bg_rgb_color_sequence, bg_index_color_sequence>)
+            ++m_stats.m_bg_color_sequences;
+         else if constexpr (std::is_same_v<sequence_type, underline_sequence>)
+            ++m_stats.m_underline_sequences;
+         else if constexpr (std::is_same_v<sequence_type, bold_sequence>)
+            ++m_stats.m_bold_sequences;
+         else if constexpr (std::is_same_v<sequence_type, reset_sequence>)
+            ++m_stats.m_reset_sequences;
+      }, sequence);
+   }
+}
+#endif
+
+
+auto oof::detail::get_pixel_runs(
+   const int width, const int height,
+   const std::vector<uint8_t>& mask
+) -> std::vector<pixel_run>
+{
+   std::vector<pixel_run> runs;
+   for (int row = 0; row < height; ++row)
+   {
+      const uint8_t* const row_begin = mask.data() + static_cast<size_t>(row) * width;
+      int x = 0;
+      while (x < width)
+      {
+         if (row_begin[x] == 0)
+         {
+            ++x;
+            continue;
+         }
+         const int run_start = x;
+         while (x < width && row_begin[x] != 0)
+            ++x;
+         runs.push_back(pixel_run{ row, run_start, x - run_start });
+      }
+   }
+   return runs;
+}
+
+
+auto oof::detail::get_blended(const color& background, const color& foreground, const uint8_t alpha) -> color
+{
+   const auto blend_component = [&](const uint8_t bg, const uint8_t fg) {
+      return (fg * alpha + bg * (255 - alpha) + 127) / 255;
+   };
+   return color{
+      blend_component(background.red, foreground.red),
+      blend_component(background.green, foreground.green),
+      blend_component(background.blue, foreground.blue)
+   };
+}
+
+
+auto oof::detail::blend_rect(
+   const raster_view<color>& view,
+   const int column, const int row,
+   const int width, const int height,
+   const color& col,
+   const uint8_t alpha
+) -> void
+{
+   const int first_column = std::max(column, 0);
+   const int end_column = std::min(column + width, view.m_width);
+   const int first_row = std::max(row, 0);
+   const int end_row = std::min(row + height, view.m_height);
+   for (int y = first_row; y < end_row; ++y)
+   {
+      color* const row_begin = view.m_data + static_cast<ptrdiff_t>(y) * view.m_width;
+      for (int x = first_column; x < end_column; ++x)
+         row_begin[x] = get_blended(row_begin[x], col, alpha);
+   }
+}
+
+
+template<typename fun_type>
+auto oof::detail::run_parallel(const int count, const fun_type& fun) -> void
+{
+   std::vector<std::jthread> threads;
+   threads.reserve(count - 1);
+   for (int i = 1; i < count; ++i)
+      threads.emplace_back(fun, i);
+   fun(0);
+}
+
+
+auto oof::detail::get_color_error(const color& a, const color& b) -> int
+{
+   return std::abs(a.red - b.red) + std::abs(a.green - b.green) + std::abs(a.blue - b.blue);
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::detail::get_cell_error(
+   const cell<string_type>& a,
+   const cell<string_type>& b
+) -> int
+{
+   constexpr int letter_error = 3 * 255;
+   constexpr int style_error = 255;
+   int error = get_color_error(a.m_format.m_fg_color, b.m_format.m_fg_color);
+   error += get_color_error(a.m_format.m_bg_color, b.m_format.m_bg_color);
+   if (a.m_letter != b.m_letter)
+      error += letter_error;
+   if (a.m_format.m_underline != b.m_format.m_underline)
+      error += style_error;
+   if (a.m_format.m_bold != b.m_format.m_bold)
+      error += style_error;
+   return error;
+}
+
+
+template<oof::std_string_type string_type>
+auto oof::detail::get_inverted_cell(const cell<string_type>& in) -> cell<string_type>
+{
+   using char_type = typename string_type::value_type;
+   constexpr auto get_inverted_color = [](const color& col) {
+      return color{ 255 - col.red, 255 - col.green, 255 - col.blue };
+   };
+   return cell<string_type>{
+      .m_letter = static_cast<char_type>(in.m_letter ^ 1),
+      .m_format = {
+         .m_underline = !in.m_format.m_underline,
+         .m_bold = !in.m_format.m_bold,
+         .m_fg_color = get_inverted_color(in.m_format.m_fg_color),
+         .m_bg_color = get_inverted_color(in.m_format.m_bg_color)
+      }
+   };
+}
+
+
 template<typename sequence_type>
 oof::detail::extender<sequence_type>::operator std::string() const{
    const sequence_type& sequence = static_cast<const sequence_type&>(*this);
@@ -0,0 +1,203 @@
+#include "doctest.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <random>
+
+#include "../oof.h"
+using namespace oof;
+
+
+// Replaces the global allocation functions for the whole test binary. Allocations are only counted while a
+// counting_scope is alive
+namespace {
+
+   std::atomic<bool> is_counting = false;
+   std::atomic<int> allocation_count = 0;
+
+   struct counting_scope {
+      counting_scope() {
+         allocation_count = 0;
+         is_counting = true;
+      }
+      ~counting_scope() {
+         is_counting = false;
+      }
+      counting_scope(const counting_scope&) = delete;
+      auto operator=(const counting_scope&) -> counting_scope& = delete;
+
+      [[nodiscard]] auto get_count() const -> int {
+         return allocation_count;
+      }
+   };
+
+   auto counted_allocate(const std::size_t size) -> void*
+   {
+      if (is_counting)
+         ++allocation_count;
+      if (void* const result = std::malloc(size == 0 ? 1 : size))
+         return result;
+      throw std::bad_alloc{};
+   }
+
+
+   template<typename string_type>
+   auto randomize(screen<string_type>& scr, std::mt19937& rng, const int change_percent) -> void
+   {
+      std::uniform_int_distribution<int> percent_dist(0, 99);
+      std::uniform_int_distribution<int> letter_dist('a', 'z');
+      std::uniform_int_distribution<int> component_dist(0, 255);
+      for (cell<string_type>& target : scr)
+      {
+         if (percent_dist(rng) >= change_percent)
+            continue;
+         target.m_letter = static_cast<typename string_type::value_type>(letter_dist(rng));
+         target.m_format.m_fg_color = color{ component_dist(rng), component_dist(rng), component_dist(rng) };
+         target.m_format.m_bg_color = color{ component_dist(rng), component_dist(rng), component_dist(rng) };
+         target.m_format.m_underline = percent_dist(rng) < 50;
+      }
+   }
+
+
+   auto randomize(pixel_screen& px, std::mt19937& rng, const int change_percent) -> void
+   {
+      std::uniform_int_distribution<int> percent_dist(0, 99);
+      std::uniform_int_distribution<int> component_dist(0, 255);
+      for (color& target : px)
+      {
+         if (percent_dist(rng) < change_percent)
+            target = color{ component_dist(rng), component_dist(rng), component_dist(rng) };
+      }
+   }
+
+} // namespace {}
+
+auto operator new(const std::size_t size) -> void* { return counted_allocate(size); }
+auto operator new[](const std::size_t size) -> void* { return counted_allocate(size); }
+auto operator delete(void* ptr) noexcept -> void { std::free(ptr); }
+auto operator delete[](void* ptr) noexcept -> void { std::free(ptr); }
+auto operator delete(void* ptr, std::size_t) noexcept -> void { std::free(ptr); }
+auto operator delete[](void* ptr, std::size_t) noexcept -> void { std::free(ptr); }
+
+
+// After a warm-up frame that changes everything, the buffers are big enough for every later frame
+TEST_CASE("allocation-free steady state")
+{
+   std::mt19937 rng(11);
+
+   SUBCASE("screen") {
+      screen<std::string> scr(60, 20, 2, 1, ' ');
+      scr.set_synchronized_output(true);
+      std::string buffer;
+      randomize(scr, rng, 100);
+      scr.get_string(buffer);
+
+      const counting_scope scope;
+      for (int frame = 0; frame < 20; ++frame)
+      {
+         randomize(scr, rng, frame % 5 == 0 ? 100 : 10);
+         scr.get_string(buffer);
+      }
+      CHECK(scope.get_count() == 0);
+   }
+
+   SUBCASE("static_screen") {
+      static_screen<20, 2, std::string> status(0, 0, ' ');
+      std::string buffer;
+      status.write_into("aaaaaaaaaaaaaaaaaaaa", 0, 0, cell_format{ false, false, color{ 255, 0, 0 }, color{ 0, 0, 255 } });
+      status.get_string(buffer);
+
+      const counting_scope scope;
+      for (int frame = 0; frame < 20; ++frame)
+      {
+         status.get_cell(frame, 1).m_letter = 'x';
+         status.get_string(buffer);
+      }
+      CHECK(scope.get_count() == 0);
+   }
+
+   SUBCASE("screen with a byte budget and regions") {
+      screen<std::wstring> scr(40, 10, 0, 0, L' ');
+      scr.set_priority(0, 0, 10, 10, 1);
+      std::wstring buffer;
+      randomize(scr, rng, 100);
+      scr.get_string(buffer);
+      randomize(scr, rng, 100);
+      scr.get_string(buffer, 1000);
+      scr.get_string(buffer, 5, 2, 20, 5);
+
+      const counting_scope scope;
+      for (int frame = 0; frame < 20; ++frame)
+      {
+         randomize(scr, rng, 30);
+         scr.get_string(buffer, 1000);
+         scr.get_string(buffer, 5, 2, 20, 5);
+      }
+      CHECK(scope.get_count() == 0);
+   }
+
+   SUBCASE("pixel_screen") {
+      for (const pixel_mode mode : { pixel_mode::half_block, pixel_mode::quadrant, pixel_mode::sextant })
+      {
+         pixel_screen px(40, 24, 0, 0, color{}, mode);
+         std::wstring buffer;
+         randomize(px, rng, 100);
+         px.get_string(buffer);
+
+         const counting_scope scope;
+         for (int frame = 0; frame < 10; ++frame)
+         {
+            randomize(px, rng, 20);
+            px.get_string(buffer);
+         }
+         CHECK(scope.get_count() == 0);
+      }
+   }
+
+   SUBCASE("braille_screen") {
+      braille_screen braille(30, 8);
+      std::uniform_int_distribution<int> x_dist(0, braille.get_dot_width() - 1);
+      std::uniform_int_distribution<int> y_dist(0, braille.get_dot_height() - 1);
+      std::wstring buffer;
+      for (int y = 0; y < braille.get_dot_height(); ++y)
+         for (int x = 0; x < braille.get_dot_width(); x += 2)
+            braille.set_dot(x, y, color{ 255, 0, 0 });
+      braille.get_string(buffer);
+
+      const counting_scope scope;
+      for (int frame = 0; frame < 10; ++frame)
+      {
+         for (int i = 0; i < 30; ++i)
+            braille.set_dot(x_dist(rng), y_dist(rng));
+         braille.get_string(buffer);
+      }
+      CHECK(scope.get_count() == 0);
+   }
+
+   SUBCASE("compositor and viewport") {
+      compositor<std::string> comp(30, 10, 0, 0, cell<std::string>{ ' ' });
+      const int layer_id = comp.add_layer(2, 2, 10, 5, 1);
+      std::string buffer;
+      randomize(comp.get_layer(layer_id), rng, 100);
+      comp.set_layer_position(layer_id, 1, 2);
+      comp.get_string(buffer);
+
+      viewport<std::string> view(30, 100, 30, 8, 0, 0, cell<std::string>{ ' ' });
+      view.set_terminal_scrolling(true);
+      randomize(view.get_canvas(), rng, 100);
+      std::string view_buffer;
+      view.get_string(view_buffer);
+
+      const counting_scope scope;
+      for (int frame = 0; frame < 10; ++frame)
+      {
+         randomize(comp.get_layer(layer_id), rng, 30);
+         comp.set_layer_position(layer_id, frame, 2);
+         comp.get_string(buffer);
+         view.set_offset(0, frame * 3);
+         view.get_string(view_buffer);
+      }
+      CHECK(scope.get_count() == 0);
+   }
+}
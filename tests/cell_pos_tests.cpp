@@ -9,9 +9,28 @@ TEST_CASE("cell_pos")
    SUBCASE("is_end") {
       detail::cell_pos p0{ 10, 5 };
       CHECK_FALSE(p0.is_end());
-      p0.m_index = 49;
+      p0.set_index(49);
       CHECK_FALSE(p0.is_end());
       ++p0;
       CHECK(p0.is_end());
    }
+
+   SUBCASE("incrementing carries column and line") {
+      detail::cell_pos p0{ 3, 4 };
+      bool all_consistent = true;
+      for (int i = 0; i < 12; ++i, ++p0)
+      {
+         detail::cell_pos jumped{ 3, 4 };
+         jumped.set_index(i);
+         all_consistent = all_consistent && p0 == jumped && p0.get_column() == i % 3 && p0.get_line() == i / 3;
+      }
+      CHECK(all_consistent);
+      CHECK(p0.is_end());
+
+      p0.set_position(2, 1);
+      CHECK(p0.m_index == 5);
+      ++p0;
+      CHECK(p0.get_column() == 0);
+      CHECK(p0.get_line() == 2);
+   }
 }
@@ -1,4 +1,6 @@
-#include "doctest.h"
+﻿#include "doctest.h"
+
+#include <sstream>
 
 #include "../oof.h"
 using namespace oof;
@@ -18,7 +20,7 @@ TEST_CASE("write_int_to_string()")
 {
    SUBCASE("std::string") {
       bool all_correct = true;
-      for (int i = 0; i < 255; ++i) {
+      for (int i = 0; i < 65536; ++i) {
          std::string str;
          detail::write_int_to_string(str, i, false);
          if (str != std::to_string(i)) {
@@ -30,7 +32,7 @@ TEST_CASE("write_int_to_string()")
 
    SUBCASE("std::wstring") {
       bool all_correct = true;
-      for (int i = 0; i < 255; ++i) {
+      for (int i = 0; i < 65536; ++i) {
          std::wstring str;
          detail::write_int_to_string(str, i, false);
          if (str != std::to_wstring(i)) {
@@ -56,6 +58,8 @@ TEST_CASE("get_sequence_string_size")
    CHECK(has_correct_size(wchar_sequence{ .m_letter=L'A'}));
    CHECK(has_correct_size(position_sequence{.m_line=0, .m_column=0}));
    CHECK(has_correct_size(position_sequence{.m_line=11, .m_column=112}));
+   CHECK(has_correct_size(position_sequence{.m_line=149, .m_column=1999}));
+   CHECK(has_correct_size(hposition_sequence{.m_column=12345}));
    CHECK(has_correct_size(hposition_sequence{.m_column=1}));
    CHECK(has_correct_size(hposition_sequence{.m_column=11}));
    CHECK(has_correct_size(vposition_sequence{.m_line=1 }));
@@ -71,4 +75,121 @@ TEST_CASE("get_sequence_string_size")
    CHECK(has_correct_size(fg_index_color_sequence{.m_index=0}));
    CHECK(has_correct_size(fg_index_color_sequence{.m_index=11}));
    CHECK(has_correct_size(set_index_color_sequence{ .m_index=1, .m_color=color{1, 12, 255} }));
+   CHECK(has_correct_size(begin_sync_sequence{}));
+   CHECK(has_correct_size(end_sync_sequence{}));
+   CHECK(has_correct_size(scroll_region_sequence{ .m_top_line=0, .m_bottom_line=99 }));
+   CHECK(has_correct_size(reset_scroll_region_sequence{}));
+   CHECK(has_correct_size(scroll_up_sequence{ .m_amount=1 }));
+   CHECK(has_correct_size(scroll_down_sequence{ .m_amount=120 }));
+   CHECK(has_correct_size(bg_index_color_sequence{ .m_index=200 }));
+   CHECK(has_correct_size(set_index_color_sequence{ .m_index=100, .m_color=color{0, 15, 16} }));
+   CHECK(has_correct_size(set_index_color_sequence{ .m_index=255, .m_color=color{255, 255, 255} }));
+}
+
+
+TEST_CASE("compose_sequences")
+{
+   SUBCASE("same output as write_sequence_into_string") {
+      constexpr auto style = compose_sequences<char>(reset_formatting(), fg_color(color{ 255, 0, 0 }), bold(), underline());
+      const std::string expected = std::string(reset_formatting()) + std::string(fg_color(color{ 255, 0, 0 })) + std::string(bold()) + std::string(underline());
+      CHECK(style.get_view() == expected);
+
+      constexpr auto wide = compose_sequences<wchar_t>(position(11, 2), set_index_color(3, color{ 1, 200, 30 }), bg_color(3), wchar_sequence{ .m_letter=L'x' });
+      const std::wstring wide_expected = std::wstring(position(11, 2)) + std::wstring(set_index_color(3, color{ 1, 200, 30 })) + std::wstring(bg_color(3)) + L"x";
+      CHECK(std::wstring(wide.get_view()) == wide_expected);
+   }
+
+   SUBCASE("formatted at compile time") {
+      static_assert(compose_sequences<char>(bold()).get_view() == "\x1b[1m");
+      static_assert(compose_sequences<char>(move_up(12), bold(false)).get_view() == "\x1b[12A\x1b[22m");
+      static_assert(compose_sequences<char>().get_view().empty());
+   }
+
+   SUBCASE("upper bounds are reached by the longest parameters") {
+      CHECK(detail::get_max_sequence_string_size<position_sequence>() == get_correct_size(position_sequence{ .m_line=65535, .m_column=65535 }));
+      CHECK(detail::get_max_sequence_string_size<fg_rgb_color_sequence>() == get_correct_size(fg_rgb_color_sequence{ .m_color=color{ 255 } }));
+      CHECK(detail::get_max_sequence_string_size<bg_index_color_sequence>() == get_correct_size(bg_index_color_sequence{ .m_index=255 }));
+      CHECK(detail::get_max_sequence_string_size<set_index_color_sequence>() == get_correct_size(set_index_color_sequence{ .m_index=255, .m_color=color{ 255 } }));
+      CHECK(detail::get_max_sequence_string_size<underline_sequence>() == get_correct_size(underline_sequence{ .m_underline=false }));
+      CHECK(detail::get_max_sequence_string_size<scroll_region_sequence>() == get_correct_size(scroll_region_sequence{ .m_top_line=65535, .m_bottom_line=65535 }));
+      CHECK(detail::get_max_sequence_string_size<move_left_sequence>() == get_correct_size(move_left_sequence{ .m_amount=65535 }));
+      CHECK(detail::get_max_sequence_string_size<wchar_sequence>() == 1);
+   }
+}
+
+
+TEST_CASE("operator<<")
+{
+   std::ostringstream stream;
+   stream << fg_color(color{ 255, 10, 0 }) << "a" << position(65535, 12) << set_index_color(255, color{ 255 });
+   CHECK(stream.str() == std::string(fg_color(color{ 255, 10, 0 })) + "a" + std::string(position(65535, 12)) + std::string(set_index_color(255, color{ 255 })));
+
+   std::wostringstream wide_stream;
+   wide_stream << bg_color(7) << wchar_sequence{ .m_letter=L'x' } << reset_formatting();
+   CHECK(wide_stream.str() == std::wstring(bg_color(7)) + L"x" + std::wstring(reset_formatting()));
+}
+
+
+TEST_CASE("sequence_code_buffer")
+{
+   const std::vector<sequence_variant_type> sequences{
+      fg_rgb_color_sequence{ .m_color=color{ 255, 0, 9 } }, fg_index_color_sequence{ .m_index=255 },
+      bg_rgb_color_sequence{ .m_color=color{ 1, 2, 3 } }, bg_index_color_sequence{ .m_index=0 },
+      set_index_color_sequence{ .m_index=200, .m_color=color{ 255 } },
+      position_sequence{ .m_line=65535, .m_column=127 }, hposition_sequence{ .m_column=128 }, vposition_sequence{ .m_line=0 },
+      store_position_sequence{}, load_position_sequence{},
+      underline_sequence{ .m_underline=true }, underline_sequence{ .m_underline=false },
+      bold_sequence{ .m_bold=true }, bold_sequence{ .m_bold=false },
+      cursor_visibility_sequence{ .m_visibility=false }, cursor_visibility_sequence{ .m_visibility=true },
+      char_sequence{ .m_letter='x' }, wchar_sequence{ .m_letter=L'\x2588' },
+      reset_sequence{}, clear_screen_sequence{},
+      move_left_sequence{ .m_amount=1 }, move_right_sequence{ .m_amount=300 }, move_up_sequence{ .m_amount=16383 }, move_down_sequence{ .m_amount=16384 },
+      begin_sync_sequence{}, end_sync_sequence{},
+      scroll_region_sequence{ .m_top_line=1, .m_bottom_line=1000 }, reset_scroll_region_sequence{},
+      scroll_up_sequence{ .m_amount=2 }, scroll_down_sequence{ .m_amount=65535 }
+   };
+
+   SUBCASE("round trip") {
+      const sequence_code_buffer code(sequences);
+      CHECK(code.get_sequence_count() == sequences.size());
+      const std::vector<sequence_variant_type> decoded = code.get_sequences();
+      REQUIRE(decoded.size() == sequences.size());
+      for (size_t i = 0; i < sequences.size(); ++i)
+      {
+         CHECK(decoded[i].index() == sequences[i].index());
+         CHECK(get_string_from_sequences<std::wstring>({ decoded[i] }) == get_string_from_sequences<std::wstring>({ sequences[i] }));
+      }
+   }
+
+   SUBCASE("same output as the variant vector") {
+      const sequence_code_buffer code(sequences);
+      CHECK(get_string_from_sequences<std::wstring>(code) == get_string_from_sequences<std::wstring>(sequences));
+      CHECK(get_string_reserve_size(code) == get_string_reserve_size(sequences));
+
+      std::string target = "a";
+      sequence_code_buffer narrow;
+      narrow.push_back(bold_sequence{ .m_bold=true });
+      narrow.push_back(char_sequence{ .m_letter='b' });
+      write_sequences_into_string(target, narrow);
+      CHECK(target == "a" + std::string(bold()) + "b");
+   }
+
+   SUBCASE("screen frames") {
+      screen<std::string> scr(20, 5, 1, 2, ' ');
+      scr.write_into("hello", 2, 1, cell_format{ true, false, color{ 255, 0, 0 }, color{} });
+      std::string buffer;
+      scr.get_string(buffer);
+      const std::vector<sequence_variant_type>& frame = scr.get_sequences();
+      const sequence_code_buffer code(frame);
+      CHECK(get_string_from_sequences<std::string>(code) == get_string_from_sequences<std::string>(frame));
+      CHECK(code.get_byte_size() * 4 < frame.size() * sizeof(sequence_variant_type));
+   }
+
+   SUBCASE("clear") {
+      sequence_code_buffer code(sequences);
+      code.clear();
+      CHECK(code.empty());
+      CHECK(code.get_byte_size() == 0);
+      CHECK(code.get_sequences().empty());
+   }
 }
@@ -0,0 +1,132 @@
+#include "doctest.h"
+
+#include <random>
+
+#include "../oof.h"
+#include "vt_emulator.h"
+
+using namespace oof;
+using namespace oof::testing;
+
+
+namespace {
+
+   template<typename string_type>
+   auto randomize(screen<string_type>& scr, std::mt19937& rng, const int change_percent) -> void
+   {
+      std::uniform_int_distribution<int> percent_dist(0, 99);
+      std::uniform_int_distribution<int> letter_dist('a', 'z');
+      std::uniform_int_distribution<int> component_dist(0, 3);
+      for (cell<string_type>& target : scr)
+      {
+         if (percent_dist(rng) >= change_percent)
+            continue;
+         target.m_letter = static_cast<typename string_type::value_type>(letter_dist(rng));
+         target.m_format.m_fg_color = color{ component_dist(rng) * 85, 0, 255 };
+         target.m_format.m_bg_color = color{ 0, component_dist(rng) * 85, 0 };
+         target.m_format.m_bold = component_dist(rng) == 0;
+         target.m_format.m_underline = component_dist(rng) == 0;
+      }
+   }
+
+} // namespace {}
+
+
+TEST_CASE("vt_emulator")
+{
+   vt_emulator<std::string> emulator(20, 5);
+
+   SUBCASE("letters, positions and formats") {
+      emulator.write(std::string(position(1, 2)) + std::string(fg_color(color{ 255, 0, 0 })) + "ab");
+      CHECK(emulator.get_cell(2, 1).m_letter == 'a');
+      CHECK(emulator.get_cell(3, 1).m_format.m_fg_color == color{ 255, 0, 0 });
+      CHECK(emulator.get_cursor_column() == 4);
+      emulator.write(std::string(reset_formatting()) + std::string(bold()) + std::string(move_left(3)) + "x");
+      CHECK(emulator.get_cell(1, 1).m_letter == 'x');
+      CHECK(emulator.get_cell(1, 1).m_format.m_bold);
+      CHECK(emulator.get_cell(1, 1).m_format.m_fg_color == color{ 255, 255, 255 });
+      CHECK(emulator.get_stats(sequence_kind::letter).m_count == 3);
+      CHECK(emulator.get_stats(sequence_kind::unknown).m_count == 0);
+
+      screen<std::string> expected(2, 1, 0, 0, ' ');
+      CHECK_FALSE(emulator.shows(expected, 2, 2, 1));
+   }
+
+   SUBCASE("index colors") {
+      emulator.write(std::string(set_index_color(3, color{ 1, 200, 30 })) + std::string(bg_color(3)) + "z");
+      CHECK(emulator.get_cell(0, 0).m_format.m_bg_color == color{ 1, 200, 30 });
+      CHECK(emulator.get_stats(sequence_kind::palette).m_count == 1);
+   }
+
+   SUBCASE("wrapping at the right edge") {
+      emulator.write(std::string(position(0, 19)) + "ab");
+      CHECK(emulator.get_cell(19, 0).m_letter == 'a');
+      CHECK(emulator.get_cell(0, 1).m_letter == 'b');
+   }
+
+   SUBCASE("scroll regions") {
+      emulator.write(std::string(position(2, 0)) + "c" + std::string(scroll_region(1, 3)) + std::string(scroll_up(1)));
+      CHECK(emulator.get_cell(0, 1).m_letter == 'c');
+      CHECK(emulator.get_cell(0, 2).m_letter == ' ');
+   }
+}
+
+
+TEST_CASE("emulated screen output")
+{
+   std::mt19937 rng(5);
+
+   SUBCASE("randomized frames at different origins") {
+      for (const auto& [width, height, column, line] : { std::array{ 17, 5, 0, 0 }, std::array{ 9, 7, 3, 2 }, std::array{ 30, 1, 10, 9 } })
+      {
+         screen<std::string> scr(width, height, column, line, ' ');
+         vt_emulator<std::string> emulator(50, 12);
+         bool all_shown = true;
+         for (int frame = 0; frame < 30; ++frame)
+         {
+            randomize(scr, rng, frame % 3 == 0 ? 100 : 10);
+            emulator.write(scr.get_string());
+            all_shown = all_shown && emulator.shows(scr, width, column, line);
+         }
+         CHECK(all_shown);
+         CHECK(emulator.get_stats(sequence_kind::unknown).m_count == 0);
+      }
+   }
+
+   SUBCASE("wide strings and multiple threads") {
+      screen<std::wstring> scr(40, 9, 1, 1, L' ');
+      scr.set_thread_count(3);
+      vt_emulator<std::wstring> emulator(41, 10);
+      bool all_shown = true;
+      for (int frame = 0; frame < 20; ++frame)
+      {
+         randomize(scr, rng, 20);
+         emulator.write(scr.get_string());
+         all_shown = all_shown && emulator.shows(scr, 40, 1, 1);
+      }
+      CHECK(all_shown);
+   }
+
+   SUBCASE("viewport with terminal scrolling") {
+      viewport<std::string> view(30, 200, 30, 8, 0, 2, cell<std::string>{ ' ' });
+      view.set_terminal_scrolling(true);
+      // Only two letters, so a wrongly skipped cell is likely to show up
+      std::uniform_int_distribution<int> letter_dist('a', 'b');
+      for (cell<std::string>& target : view.get_canvas())
+         target.m_letter = static_cast<char>(letter_dist(rng));
+      vt_emulator<std::string> emulator(30, 12);
+      bool all_shown = true;
+      for (const int offset : { 0, 1, 3, 2, 9, 50, 49, 49, 57 })
+      {
+         view.set_offset(0, offset);
+         emulator.write(view.get_string());
+         screen<std::string> expected(30, 8, 0, 0, ' ');
+         for (int line = 0; line < 8; ++line)
+            for (int column = 0; column < 30; ++column)
+               expected.get_cell(column, line) = view.get_canvas().get_cell(column, offset + line);
+         all_shown = all_shown && emulator.shows(expected, 30, 0, 2);
+      }
+      CHECK(all_shown);
+      CHECK(emulator.get_stats(sequence_kind::scroll).m_count > 0);
+   }
+}
@@ -0,0 +1,636 @@
+#include "doctest.h"
+
+#include <random>
+#include <thread>
+
+#include "../oof.h"
+using namespace oof;
+
+
+TEST_CASE("byte budget")
+{
+   screen<std::string> scr(20, 5, 0, 0, ' ');
+   for (cell<std::string>& c : scr)
+      c.m_letter = 'x';
+
+   SUBCASE("output stays within the budget and converges") {
+      constexpr size_t budget = 100;
+      std::string buffer;
+      int frames = 0;
+      bool all_within_budget = true;
+      while (frames < 100) {
+         scr.get_string(buffer, budget);
+         if (buffer.size() > budget)
+            all_within_budget = false;
+         ++frames;
+         if (buffer == std::string(reset_formatting()))
+            break;
+      }
+      CHECK(all_within_budget);
+      CHECK(frames > 1);
+      CHECK(frames < 100);
+      CHECK(scr.get_string() == std::string(reset_formatting()));
+   }
+
+   SUBCASE("prioritized regions are sent first") {
+      scr.set_priority(10, 4, 2, 1, 1);
+      std::string buffer;
+      scr.get_string(buffer, 56);
+      CHECK(buffer.find(std::string(position(4, 10))) != std::string::npos);
+      CHECK(buffer.find(std::string(position(0, 0))) == std::string::npos);
+   }
+
+   SUBCASE("too small budget sends nothing") {
+      std::string buffer;
+      scr.get_string(buffer, 2);
+      CHECK(buffer.empty());
+   }
+}
+
+
+TEST_CASE("synchronized output")
+{
+   screen<std::string> scr(4, 2, 0, 0, 'x');
+   scr.set_synchronized_output(true);
+   const std::string result = scr.get_string();
+   CHECK(result.starts_with("\x1b[?2026h"));
+   CHECK(result.ends_with("\x1b[?2026l"));
+}
+
+
+TEST_CASE("multithreaded output")
+{
+   std::mt19937 rng(123);
+   const auto randomize = [&](auto& scr, const int change_percentage) {
+      for (auto& c : scr) {
+         if (static_cast<int>(rng() % 100) >= change_percentage)
+            continue;
+         c.m_letter = static_cast<char>('a' + rng() % 26);
+         c.m_format.m_fg_color = color{ static_cast<int>(rng() % 4) * 80 };
+         c.m_format.m_bold = rng() % 2 == 0;
+      }
+   };
+
+   screen<std::string> single(523, 151, 3, 2, ' ');
+   single.set_synchronized_output(true);
+
+   bool all_identical = true;
+   for (const int change_percentage : { 100, 50, 1, 0, 10 }) {
+      randomize(single, change_percentage);
+      screen<std::string> multi = single;
+      multi.set_thread_count(7);
+      if (single.get_string() != multi.get_string())
+         all_identical = false;
+   }
+   CHECK(all_identical);
+}
+
+
+TEST_CASE("presenter")
+{
+   screen<std::string> reference(10, 4, 0, 0, ' ');
+
+   SUBCASE("block policy writes every frame like a direct get_string()") {
+      const auto draw = [](screen<std::string>& scr, const int frame) {
+         for (cell<std::string>& c : scr)
+            c.m_letter = static_cast<char>('a' + frame);
+         scr.get_cell(frame % 10, frame % 4).m_format.m_bold = true;
+      };
+      std::string written;
+      std::string expected;
+      {
+         presenter<screen<std::string>> pres(reference, [&](const std::string& str) { written += str; }, 3);
+         for (int frame = 0; frame < 20; ++frame) {
+            draw(reference, frame);
+            expected += reference.get_string();
+            draw(pres.get_canvas(), frame);
+            pres.present();
+         }
+         pres.wait_until_written();
+         CHECK(pres.get_stats().m_written_frames == 20);
+         CHECK(pres.get_stats().m_dropped_frames == 0);
+      }
+      CHECK(written == expected);
+   }
+
+   SUBCASE("drop policy skips frames when the output is slow") {
+      presenter<screen<std::string>> pres(
+         reference,
+         [](const std::string&) { std::this_thread::sleep_for(std::chrono::milliseconds(5)); },
+         2, present_policy::drop_frame
+      );
+      for (int frame = 0; frame < 20; ++frame)
+         pres.present();
+      pres.wait_until_written();
+      const presenter_stats stats = pres.get_stats();
+      CHECK(stats.m_dropped_frames > 0);
+      CHECK(stats.m_written_frames + stats.m_dropped_frames == 20);
+   }
+}
+
+
+TEST_CASE("pixel_screen half-block packing")
+{
+   for (const int origin_halfline : { 0, 1, 4, 7 }) {
+      for (const int halfline_height : { 1, 4, 5 }) {
+         const color fill{ 1, 2, 3 };
+         pixel_screen px(3, halfline_height, 0, origin_halfline, fill);
+         screen<std::wstring>& scr = px.get_screen_ref();
+         for (int i = 0; color& pixel : px)
+            pixel = color{ i++ * 10 };
+         (void)px.get_string();
+
+         const int halfline_offset = origin_halfline % 2;
+         const auto get_expected = [&](const int column, const int halfline) {
+            if (halfline < 0 || halfline >= halfline_height)
+               return fill;
+            return color{ (halfline * 3 + column) * 10 };
+         };
+
+         bool all_correct = true;
+         for (int line = 0; line < scr.get_height(); ++line) {
+            for (int column = 0; column < scr.get_width(); ++column) {
+               const cell_format& format = scr.get_cell(column, line).m_format;
+               if (format.m_fg_color != get_expected(column, 2 * line - halfline_offset))
+                  all_correct = false;
+               if (format.m_bg_color != get_expected(column, 2 * line - halfline_offset + 1))
+                  all_correct = false;
+            }
+         }
+         CHECK(all_correct);
+      }
+   }
+}
+
+
+TEST_CASE("pixel_screen direct rendering")
+{
+   std::mt19937 rng(42);
+   for (const pixel_mode mode : { pixel_mode::half_block, pixel_mode::quadrant, pixel_mode::sextant })
+   for (const int origin : { 0, 3, 4 }) {
+      pixel_screen direct(17, 9, origin, origin, color{ 5 }, mode);
+      pixel_screen through_screen = direct;
+      (void)through_screen.get_screen_ref();
+
+      bool all_identical = true;
+      for (const int change_percentage : { 100, 30, 0, 2 }) {
+         for (color& pixel : direct) {
+            if (static_cast<int>(rng() % 100) < change_percentage)
+               pixel = color{ static_cast<int>(rng() % 256) };
+         }
+         std::ranges::copy(direct, through_screen.begin());
+         if (direct.get_string() != through_screen.get_string())
+            all_identical = false;
+      }
+      CHECK(all_identical);
+   }
+}
+
+
+TEST_CASE("sub-cell pixel modes")
+{
+   SUBCASE("quadrant") {
+      pixel_screen px(4, 2, 0, 0, color{}, pixel_mode::quadrant);
+      screen<std::wstring>& scr = px.get_screen_ref();
+      px.get_color(0, 0) = color{ 255 };
+      px.get_color(3, 0) = color{ 255 };
+      px.get_color(2, 1) = color{ 255 };
+      (void)px.get_string();
+      CHECK(scr.get_width() == 2);
+      CHECK(scr.get_height() == 1);
+      CHECK(scr.get_cell(0, 0).m_letter == L'\u2598');
+      CHECK(scr.get_cell(0, 0).m_format.m_fg_color == color{ 255 });
+      CHECK(scr.get_cell(0, 0).m_format.m_bg_color == color{ 0 });
+      CHECK(scr.get_cell(1, 0).m_letter == L'\u259E');
+   }
+
+   SUBCASE("sextant") {
+      pixel_screen px(2, 3, 0, 0, color{}, pixel_mode::sextant);
+      screen<std::wstring>& scr = px.get_screen_ref();
+      px.get_color(0, 0) = color{ 200, 10, 10 };
+      (void)px.get_string();
+      if constexpr (sizeof(wchar_t) == 4)
+         CHECK(scr.get_cell(0, 0).m_letter == static_cast<wchar_t>(0x1FB00));
+      CHECK(scr.get_cell(0, 0).m_format.m_fg_color == color{ 200, 10, 10 });
+   }
+
+   SUBCASE("uniform cells are blank") {
+      pixel_screen px(2, 3, 0, 0, color{ 7 }, pixel_mode::sextant);
+      screen<std::wstring>& scr = px.get_screen_ref();
+      (void)px.get_string();
+      CHECK(scr.get_cell(0, 0).m_letter == L' ');
+      CHECK(scr.get_cell(0, 0).m_format.m_bg_color == color{ 7 });
+   }
+}
+
+
+TEST_CASE("braille_screen")
+{
+   braille_screen br(3, 2);
+   CHECK(br.get_dot_width() == 6);
+   CHECK(br.get_dot_height() == 8);
+
+   br.set_dot(0, 0);
+   br.set_dot(1, 3);
+   br.set_dot(100, 100);
+   CHECK(br.is_dot_set(0, 0));
+   CHECK(br.is_dot_set(1, 3));
+   CHECK_FALSE(br.is_dot_set(1, 0));
+   CHECK_FALSE(br.is_dot_in(100, 100));
+
+   const std::wstring first_frame = br.get_string();
+   CHECK(first_frame.find(L'⢁') != std::wstring::npos);
+   CHECK(br.get_string() == std::wstring(reset_formatting()));
+
+   br.clear_dot(1, 3);
+   br.set_dot(5, 7, color{ 255, 0, 0 });
+   const std::wstring second_frame = br.get_string();
+   CHECK(second_frame.find(L'⠁') != std::wstring::npos);
+   CHECK(second_frame.find(L'⢀') != std::wstring::npos);
+   CHECK(br.get_color(2, 1) == color{ 255, 0, 0 });
+}
+
+
+TEST_CASE("pixel_screen accessors")
+{
+   pixel_screen px(4, 3);
+
+   SUBCASE("is_in") {
+      CHECK(px.is_in(0, 0));
+      CHECK(px.is_in(3, 2));
+      CHECK_FALSE(px.is_in(4, 0));
+      CHECK_FALSE(px.is_in(-1, 1));
+      CHECK_FALSE(px.is_in(0, 3));
+      CHECK_FALSE(px.is_in(0, -1));
+   }
+
+   SUBCASE("get_row") {
+      std::ranges::fill(px.get_row(1), color{ 9 });
+      CHECK(px.get_row(1).size() == 4);
+      CHECK(px.get_row(3).empty());
+      CHECK(px.get_color_unchecked(3, 1) == color{ 9 });
+      CHECK(px.get_color(0, 2) == color{});
+   }
+
+   SUBCASE("out of range get_color is reported") {
+      static int error_count = 0;
+      error_count = 0;
+      error_callback = [](const std::string&) { ++error_count; };
+      (void)px.get_color(4, 0);
+      (void)px.get_color(0, -1);
+      error_callback = nullptr;
+      CHECK(error_count == 2);
+   }
+}
+
+
+TEST_CASE("drawing primitives")
+{
+   const color ink{ 255, 0, 0 };
+
+   SUBCASE("fill_rect is clipped") {
+      pixel_screen px(5, 4);
+      px.fill_rect(-2, 2, 4, 10, ink);
+      int count = 0;
+      for (const color& pixel : px.m_pixels)
+         count += pixel == ink;
+      CHECK(count == 4);
+      CHECK(px.get_color(1, 3) == ink);
+      CHECK(px.get_color(2, 3) == color{});
+   }
+
+   SUBCASE("draw_rect outline") {
+      pixel_screen px(5, 5);
+      px.draw_rect(1, 1, 3, 3, ink);
+      CHECK(px.get_color(1, 1) == ink);
+      CHECK(px.get_color(3, 3) == ink);
+      CHECK(px.get_color(2, 2) == color{});
+   }
+
+   SUBCASE("draw_line endpoints and clipping") {
+      pixel_screen px(8, 8);
+      px.draw_line(0, 0, 7, 3, ink);
+      CHECK(px.get_color(0, 0) == ink);
+      CHECK(px.get_color(7, 3) == ink);
+      px.draw_line(-5, 6, 20, 6, ink);
+      CHECK(px.get_color(0, 6) == ink);
+      CHECK(px.get_color(7, 6) == ink);
+   }
+
+   SUBCASE("circles") {
+      pixel_screen px(11, 11);
+      px.draw_circle(5, 5, 4, ink);
+      CHECK(px.get_color(9, 5) == ink);
+      CHECK(px.get_color(5, 1) == ink);
+      CHECK(px.get_color(5, 5) == color{});
+      px.fill_circle(5, 5, 4, ink);
+      CHECK(px.get_color(5, 5) == ink);
+      CHECK(px.get_color(0, 0) == color{});
+      px.fill_circle(0, 0, 30, ink);
+      CHECK(px.get_color(10, 10) == ink);
+   }
+
+   SUBCASE("blend_rect") {
+      pixel_screen px(2, 2, 0, 0, color{ 0, 0, 0 });
+      px.blend_rect(0, 0, 1, 1, color{ 255, 100, 0 }, 128);
+      CHECK(px.get_color(0, 0) == color{ 128, 50, 0 });
+      px.blend_rect(1, 1, 5, 5, color{ 1, 2, 3 }, 255);
+      CHECK(px.get_color(1, 1) == color{ 1, 2, 3 });
+   }
+
+   SUBCASE("blit") {
+      pixel_screen px(4, 4);
+      const std::vector<color> source{ color{ 1 }, color{ 2 }, color{ 3 }, color{ 4 } };
+      px.blit(3, -1, source, 2);
+      CHECK(px.get_color(3, 0) == color{ 3 });
+      CHECK(px.get_color(2, 0) == color{});
+   }
+
+   SUBCASE("screen cells") {
+      screen<std::string> scr(6, 3, 0, 0, ' ');
+      scr.draw_hline(-1, 1, 10, cell<std::string>{ '-' });
+      scr.draw_vline(2, 0, 3, cell<std::string>{ '|' });
+      CHECK(scr.get_cell(0, 1).m_letter == '-');
+      CHECK(scr.get_cell(5, 1).m_letter == '-');
+      CHECK(scr.get_cell(2, 1).m_letter == '|');
+      CHECK(scr.get_cell(0, 0).m_letter == ' ');
+      CHECK(scr.get_string().find('|') != std::string::npos);
+   }
+}
+
+
+TEST_CASE("compositor")
+{
+   const cell<std::string> background{ '.', cell_format{} };
+   compositor<std::string> comp(6, 3, 0, 0, background);
+   const int bottom = comp.add_layer(0, 0, 4, 2, 0);
+   const int top = comp.add_layer(2, 1, 3, 2, 1);
+   comp.get_layer(bottom).fill_rect(0, 0, 4, 2, cell<std::string>{ 'a', cell_format{} });
+   comp.get_layer(top).fill_rect(0, 0, 3, 2, cell<std::string>{ 'b', cell_format{} });
+   comp.get_layer(top).get_cell(0, 1).m_letter = '\0';
+
+   SUBCASE("layers are stacked and overlaps written once") {
+      const std::string frame = comp.get_string();
+      CHECK(std::ranges::count(frame, 'a') == 6);
+      CHECK(std::ranges::count(frame, 'b') == 5);
+      CHECK(std::ranges::count(frame, '.') == 7);
+      CHECK(comp.get_string() == std::string(reset_formatting()));
+   }
+
+   SUBCASE("moving and hiding layers only redraws what changed") {
+      (void)comp.get_string();
+      comp.set_layer_visible(top, false);
+      const std::string hidden = comp.get_string();
+      CHECK(std::ranges::count(hidden, 'a') == 2);
+      CHECK(std::ranges::count(hidden, '.') == 3);
+      CHECK(std::ranges::count(hidden, 'b') == 0);
+
+      comp.set_layer_position(bottom, 2, 1);
+      const std::string moved = comp.get_string();
+      CHECK(std::ranges::count(moved, 'a') == 6);
+   }
+
+   SUBCASE("z order and opacity") {
+      comp.set_layer_z_order(bottom, 2);
+      const std::string frame = comp.get_string();
+      CHECK(std::ranges::count(frame, 'a') == 8);
+
+      compositor<std::string> faded(1, 1, 0, 0, cell<std::string>{ ' ', cell_format{ false, false, color{}, color{ 0, 0, 0 } } });
+      const int id = faded.add_layer(0, 0, 1, 1, 0);
+      faded.get_layer(id).get_cell(0, 0) = cell<std::string>{ 'x', cell_format{ false, false, color{ 255, 255, 255 }, color{ 200, 100, 0 } } };
+      faded.set_layer_opacity(id, 128);
+      const std::string blended = faded.get_string();
+      CHECK(blended.find(std::string(bg_color(color{ 100, 50, 0 }))) != std::string::npos);
+   }
+}
+
+
+TEST_CASE("sprites and text")
+{
+   const color a{ 10 }, b{ 20 }, c{ 30 }, d{ 40 };
+
+   SUBCASE("transparent sprite pixels are skipped") {
+      pixel_screen px(4, 3, 0, 0, color{ 1 });
+      const sprite spr(2, 2, { a, b, c, d }, { 255, 0, 0, 255 });
+      px.draw_sprite(spr, 1, 1);
+      CHECK(px.get_color(1, 1) == a);
+      CHECK(px.get_color(2, 1) == color{ 1 });
+      CHECK(px.get_color(1, 2) == color{ 1 });
+      CHECK(px.get_color(2, 2) == d);
+   }
+
+   SUBCASE("sprites are clipped") {
+      pixel_screen px(3, 3);
+      const sprite spr(2, 2, { a, b, c, d });
+      px.draw_sprite(spr, -1, 2);
+      CHECK(px.get_color(0, 2) == b);
+      CHECK(px.get_color(1, 2) == color{});
+      px.draw_sprite(spr, 2, -1);
+      CHECK(px.get_color(2, 0) == c);
+   }
+
+   SUBCASE("wrong sprite sizes are reported") {
+      static int error_count = 0;
+      error_count = 0;
+      error_callback = [](const std::string&) { ++error_count; };
+      const sprite wrong_pixels(2, 2, { a });
+      const sprite wrong_mask(1, 1, { a }, { 255, 255 });
+      error_callback = nullptr;
+      CHECK(error_count == 2);
+   }
+
+   SUBCASE("default font") {
+      const bitmap_font& font = get_default_font();
+      CHECK(font.has_glyph(L'7'));
+      CHECK(font.has_glyph(L'q'));
+      CHECK_FALSE(font.has_glyph(L'@'));
+
+      pixel_screen px(16, 24);
+      const color ink{ 255, 255, 0 };
+      px.draw_text(font, L"1\nT", 0, 0, ink, 2);
+      // The '1' has its base on its last row, the 'T' its bar on its first
+      CHECK(px.get_color(0, 8) == ink);
+      CHECK(px.get_color(5, 9) == ink);
+      CHECK(px.get_color(0, 0) == color{});
+      CHECK(px.get_color(2, 0) == ink);
+      CHECK(px.get_color(0, 12) == ink);
+      CHECK(px.get_color(0, 14) == color{});
+
+      px.draw_text(font, L"@1", 8, 0, ink);
+      CHECK(px.get_color(13, 0) == ink);
+   }
+}
+
+
+TEST_CASE("region-limited output")
+{
+   screen<std::string> scr(30, 10, 0, 0, ' ');
+   std::string buffer;
+
+   SUBCASE("changes outside the region stay pending") {
+      scr.get_string(buffer);
+      scr.get_cell(5, 2).m_letter = 'x';
+      scr.get_cell(20, 8).m_letter = 'y';
+      scr.get_string(buffer, 3, 1, 10, 3);
+      CHECK(buffer.find('x') != std::string::npos);
+      CHECK(buffer.find('y') == std::string::npos);
+      scr.get_string(buffer, 3, 1, 10, 3);
+      CHECK(buffer == std::string(reset_formatting()));
+      scr.get_string(buffer);
+      CHECK(buffer.find('x') == std::string::npos);
+      CHECK(buffer.find('y') != std::string::npos);
+   }
+
+   SUBCASE("the whole screen as region is the same as a full frame") {
+      screen<std::string> reference(30, 10, 0, 0, ' ');
+      for (screen<std::string>* target : { &scr, &reference })
+      {
+         target->get_string(buffer);
+         target->get_cell(0, 0).m_letter = 'a';
+         target->get_cell(29, 9).m_format.m_bold = true;
+      }
+      std::string reference_buffer;
+      reference.get_string(reference_buffer);
+      scr.get_string(buffer, -5, -5, 100, 100);
+      CHECK(buffer == reference_buffer);
+   }
+
+   SUBCASE("cells that were never written are sent") {
+      scr.get_string(buffer, 0, 0, 2, 1);
+      CHECK(std::ranges::count(buffer, ' ') == 2);
+      scr.get_string(buffer);
+      CHECK(std::ranges::count(buffer, ' ') == 298);
+   }
+}
+
+
+TEST_CASE("viewport")
+{
+   viewport<std::string> view(40, 100, 10, 4, 0, 0, cell<std::string>{ ' ' });
+   screen<std::string>& canvas = view.get_canvas();
+   for (int line = 0; line < canvas.get_height(); ++line)
+      canvas.get_cell(0, line).m_letter = static_cast<char>('A' + line % 26);
+
+   SUBCASE("offsets are clamped") {
+      view.set_offset(-3, 500);
+      CHECK(view.get_offset_column() == 0);
+      CHECK(view.get_offset_line() == 96);
+      view.set_offset(100, 3);
+      CHECK(view.get_offset_column() == 30);
+   }
+
+   SUBCASE("only the visible window is written") {
+      const std::string frame = view.get_string();
+      CHECK(frame.find('D') != std::string::npos);
+      CHECK(frame.find('E') == std::string::npos);
+      CHECK(view.get_string() == std::string(reset_formatting()));
+
+      view.set_offset(0, 2);
+      const std::string panned = view.get_string();
+      CHECK(panned.find(std::string(scroll_up(2))) == std::string::npos);
+      CHECK(panned.find('F') != std::string::npos);
+   }
+
+   SUBCASE("terminal scrolling only draws the lines that scrolled in") {
+      view.set_terminal_scrolling(true);
+      (void)view.get_string();
+      view.set_offset(0, 1);
+      const std::string down = view.get_string();
+      CHECK(down.find(std::string(scroll_up(1))) != std::string::npos);
+      CHECK(down.find('E') != std::string::npos);
+      CHECK(down.find('C') == std::string::npos);
+
+      view.set_offset(0, 0);
+      const std::string up = view.get_string();
+      CHECK(up.find(std::string(scroll_down(1))) != std::string::npos);
+      CHECK(up.find('A') != std::string::npos);
+      CHECK(up.find('C') == std::string::npos);
+
+      view.set_offset(0, 50);
+      const std::string jump = view.get_string();
+      CHECK(jump.find(std::string(reset_scroll_region())) == std::string::npos);
+   }
+}
+
+
+TEST_CASE("static_screen")
+{
+   static_screen<7, 3, std::string> fixed(2, 1, ' ');
+   screen<std::string> dynamic(7, 3, 2, 1, ' ');
+   static_assert(static_screen<7, 3, std::string>::get_width() == 7);
+
+   SUBCASE("same output as a screen") {
+      fixed.set_synchronized_output(true);
+      dynamic.set_synchronized_output(true);
+      bool all_equal = fixed.get_string() == dynamic.get_string();
+      for (int frame = 0; frame < 5; ++frame)
+      {
+         const cell<std::string> value{ static_cast<char>('a' + frame), cell_format{ frame % 2 == 0, false, color{ 255, 0, 0 }, color{} } };
+         fixed.get_cell(frame, frame % 3) = value;
+         dynamic.get_cell(frame, frame % 3) = value;
+         fixed.write_into("xy", 5, 2, cell_format{});
+         dynamic.write_into("xy", 5, 2, cell_format{});
+         all_equal = all_equal && fixed.get_string() == dynamic.get_string();
+      }
+      CHECK(all_equal);
+      CHECK(fixed.get_sequences().size() == dynamic.get_sequences().size());
+   }
+
+   SUBCASE("blitting into a compositor layer") {
+      fixed.write_into("status", 0, 1, cell_format{});
+      compositor<std::string> comp(10, 4, 0, 0, cell<std::string>{ '.' });
+      const int id = comp.add_layer(1, 0, fixed.get_width(), fixed.get_height(), 0);
+      comp.get_layer(id).blit(0, 0, fixed.get_cells(), fixed.get_width());
+      CHECK(comp.get_string().find("status") != std::string::npos);
+   }
+
+   SUBCASE("lines") {
+      fixed.get_line(1)[3].m_letter = 'q';
+      CHECK(fixed.get_cell(3, 1).m_letter == 'q');
+      CHECK(fixed.get_line(3).empty());
+      dynamic.get_line(2)[6].m_letter = 'r';
+      CHECK(dynamic.get_cell(6, 2).m_letter == 'r');
+      CHECK(dynamic.get_line(-1).empty());
+   }
+
+   SUBCASE("wide strings and clearing") {
+      static_screen<3, 1, std::wstring> wide(L'-');
+      wide.get_cell(1, 0).m_letter = L'x';
+      CHECK(wide.get_string().find(L'x') != std::wstring::npos);
+      wide.clear();
+      CHECK(wide.get_string().find(L'-') != std::wstring::npos);
+      CHECK(wide.get_string() == std::wstring(reset_formatting()));
+   }
+}
+
+#ifdef OOF_RENDER_STATS
+TEST_CASE("render statistics")
+{
+   screen<std::string> scr(10, 4, 0, 0, ' ');
+   std::string buffer;
+   scr.get_string(buffer);
+   const render_stats& first = scr.get_render_stats();
+   CHECK(first.m_cells_scanned == 40);
+   CHECK(first.m_cells_changed == 40);
+   CHECK(first.m_output_size == buffer.size());
+   CHECK(first.m_reallocations >= 1);
+
+   scr.get_cell(2, 1).m_letter = 'x';
+   scr.get_cell(7, 3).m_format.m_fg_color = color{ 255, 0, 0 };
+   scr.get_string(buffer);
+   const render_stats& second = scr.get_render_stats();
+   CHECK(second.m_cells_changed == 2);
+   CHECK(second.m_cursor_jumps == 2);
+   CHECK(second.m_fg_color_sequences >= 1);
+   CHECK(second.m_reset_sequences == 1);
+   CHECK(second.m_reallocations == 0);
+
+   scr.get_string(buffer, 0, 0, 3, 2);
+   CHECK(scr.get_render_stats().m_cells_scanned == 6);
+
+   pixel_screen px(4, 4);
+   (void)px.get_string();
+   CHECK(px.get_render_stats().m_cells_scanned == 8);
+   CHECK(px.get_render_stats().m_cells_changed == 8);
+}
+#endif
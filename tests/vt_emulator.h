@@ -0,0 +1,434 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "../oof.h"
+
+
+// Small model of a VT terminal that understands the sequences oof writes. It rebuilds the grid of cells from the
+// output, so tests can check that a frame shows what it should. Also counts the output by kind of sequence.
+namespace oof::testing {
+
+   enum class sequence_kind {
+      letter,
+      cursor,  // Position, move, save and restore
+      color,   // SGR colors
+      style,   // SGR reset, bold and underline
+      scroll,  // Scroll region and scrolling
+      mode,    // Cursor visibility and synchronized output
+      clear,
+      palette, // OSC 4 index color definitions
+      unknown
+   };
+   constexpr int sequence_kind_count = static_cast<int>(sequence_kind::unknown) + 1;
+
+   [[nodiscard]] constexpr auto get_kind_name(const sequence_kind kind) -> const char* {
+      constexpr std::array<const char*, sequence_kind_count> names{
+         "letter", "cursor", "color", "style", "scroll", "mode", "clear", "palette", "unknown"
+      };
+      return names[static_cast<int>(kind)];
+   }
+
+   struct kind_stats {
+      size_t m_count = 0;
+      size_t m_bytes = 0; // Letters of wide strings are counted as UTF-8
+   };
+
+
+   template<oof::std_string_type string_type>
+   struct vt_emulator {
+      using char_type = typename string_type::value_type;
+      using cell_type = cell<string_type>;
+
+      explicit vt_emulator(const int width, const int height)
+         : m_width(width)
+         , m_height(height)
+         , m_scroll_bottom(height - 1)
+         , m_cells(static_cast<size_t>(width) * height, get_blank_cell(cell_format{}))
+      {
+
+      }
+
+      // Can be called with parts of the output, the parser state is kept between calls
+      auto write(const string_type& output) -> void
+      {
+         for (const char_type letter : output)
+            this->consume(letter);
+      }
+
+      [[nodiscard]] auto get_cell(const int column, const int line) const -> const cell_type& {
+         return m_cells[static_cast<size_t>(line) * m_width + column];
+      }
+      [[nodiscard]] auto get_width() const -> int { return m_width; }
+      [[nodiscard]] auto get_height() const -> int { return m_height; }
+      [[nodiscard]] auto get_cursor_column() const -> int { return m_column; }
+      [[nodiscard]] auto get_cursor_line() const -> int { return m_line; }
+      [[nodiscard]] auto get_format() const -> const cell_format& { return m_format; }
+      [[nodiscard]] auto get_stats(const sequence_kind kind) const -> const kind_stats& {
+         return m_stats[static_cast<int>(kind)];
+      }
+      [[nodiscard]] auto get_total_bytes() const -> size_t {
+         size_t result = 0;
+         for (const kind_stats& stats : m_stats)
+            result += stats.m_bytes;
+         return result;
+      }
+      auto reset_stats() -> void {
+         m_stats = {};
+      }
+
+      // Whether the rectangle of the terminal at the origin shows these cells, which are row-major with the width
+      template<typename range_type>
+      [[nodiscard]] auto shows(const range_type& cells, const int width, const int origin_column, const int origin_line) const -> bool
+      {
+         int i = 0;
+         for (const cell_type& expected : cells)
+         {
+            const int column = origin_column + i % width;
+            const int line = origin_line + i / width;
+            ++i;
+            if (column >= m_width || line >= m_height)
+               continue;
+            if (this->get_cell(column, line) != expected)
+               return false;
+         }
+         return true;
+      }
+
+   private:
+      enum class parse_state { ground, escape, csi, osc, osc_escape };
+
+      [[nodiscard]] static auto get_blank_cell(const cell_format& format) -> cell_type {
+         return cell_type{ static_cast<char_type>(' '), format };
+      }
+
+      auto count(const sequence_kind kind, const size_t bytes) -> void {
+         kind_stats& stats = m_stats[static_cast<int>(kind)];
+         ++stats.m_count;
+         stats.m_bytes += bytes;
+      }
+
+      auto consume(const char_type letter) -> void
+      {
+         const auto code = static_cast<uint32_t>(letter);
+         switch (m_state)
+         {
+         case parse_state::ground:
+            if (letter == 0x1b)
+            {
+               m_state = parse_state::escape;
+               m_sequence.clear();
+            }
+            else if (letter == '\r')
+            {
+               m_column = 0;
+               m_pending_wrap = false;
+               this->count(sequence_kind::cursor, 1);
+            }
+            else if (letter == '\n')
+            {
+               this->line_feed();
+               this->count(sequence_kind::cursor, 1);
+            }
+            else
+            {
+               this->put_letter(letter);
+               size_t bytes = 1;
+               if constexpr (std::is_same_v<string_type, std::wstring>)
+                  bytes = code < 0x80 ? 1 : code < 0x800 ? 2 : code < 0x10000 ? 3 : 4;
+               this->count(sequence_kind::letter, bytes);
+            }
+            break;
+         case parse_state::escape:
+            if (letter == '[')
+            {
+               m_state = parse_state::csi;
+            }
+            else if (letter == ']')
+            {
+               m_state = parse_state::osc;
+            }
+            else
+            {
+               m_state = parse_state::ground;
+               this->run_escape(letter);
+            }
+            break;
+         case parse_state::csi:
+            if (code >= 0x40 && code <= 0x7e)
+            {
+               m_state = parse_state::ground;
+               this->run_csi(static_cast<char>(letter));
+            }
+            else
+            {
+               m_sequence += static_cast<char>(letter);
+            }
+            break;
+         case parse_state::osc:
+            if (letter == 0x1b)
+               m_state = parse_state::osc_escape;
+            else if (letter == 0x07)
+               this->end_osc(1);
+            else
+               m_sequence += static_cast<char>(letter);
+            break;
+         case parse_state::osc_escape:
+            this->end_osc(2);
+            break;
+         }
+      }
+
+      auto run_escape(const char_type letter) -> void
+      {
+         if (letter == '7')
+         {
+            m_saved_column = m_column;
+            m_saved_line = m_line;
+            this->count(sequence_kind::cursor, 2);
+         }
+         else if (letter == '8')
+         {
+            m_column = m_saved_column;
+            m_line = m_saved_line;
+            m_pending_wrap = false;
+            this->count(sequence_kind::cursor, 2);
+         }
+         else
+         {
+            this->count(sequence_kind::unknown, 2);
+         }
+      }
+
+      [[nodiscard]] auto get_params() const -> std::vector<int>
+      {
+         std::vector<int> result{ 0 };
+         bool has_digit = false;
+         for (const char c : m_sequence)
+         {
+            if (c == ';')
+            {
+               result.push_back(0);
+               has_digit = false;
+            }
+            else if (c >= '0' && c <= '9')
+            {
+               result.back() = result.back() * 10 + (c - '0');
+               has_digit = true;
+            }
+         }
+         if (result.size() == 1 && has_digit == false)
+            result.clear();
+         return result;
+      }
+
+      auto run_csi(const char final_byte) -> void
+      {
+         const size_t bytes = 3 + m_sequence.size();
+         const std::vector<int> params = this->get_params();
+         const auto get_param = [&](const size_t index, const int default_value) {
+            return index < params.size() && params[index] != 0 ? params[index] : default_value;
+         };
+         const bool is_private = m_sequence.empty() == false && m_sequence.front() == '?';
+
+         if (is_private && (final_byte == 'h' || final_byte == 'l'))
+         {
+            this->count(sequence_kind::mode, bytes);
+            return;
+         }
+         switch (final_byte)
+         {
+         case 'H':
+            this->set_cursor(get_param(1, 1) - 1, get_param(0, 1) - 1);
+            this->count(sequence_kind::cursor, bytes);
+            break;
+         case 'G':
+            this->set_cursor(get_param(0, 1) - 1, m_line);
+            this->count(sequence_kind::cursor, bytes);
+            break;
+         case 'd':
+            this->set_cursor(m_column, get_param(0, 1) - 1);
+            this->count(sequence_kind::cursor, bytes);
+            break;
+         case 'A':
+            this->set_cursor(m_column, m_line - get_param(0, 1));
+            this->count(sequence_kind::cursor, bytes);
+            break;
+         case 'B':
+            this->set_cursor(m_column, m_line + get_param(0, 1));
+            this->count(sequence_kind::cursor, bytes);
+            break;
+         case 'C':
+            this->set_cursor(m_column + get_param(0, 1), m_line);
+            this->count(sequence_kind::cursor, bytes);
+            break;
+         case 'D':
+            this->set_cursor(m_column - get_param(0, 1), m_line);
+            this->count(sequence_kind::cursor, bytes);
+            break;
+         case 'm':
+            this->count(this->run_sgr(params), bytes);
+            break;
+         case 'J':
+            if (get_param(0, 0) == 2)
+               std::ranges::fill(m_cells, get_blank_cell(m_format));
+            this->count(sequence_kind::clear, bytes);
+            break;
+         case 'r':
+            m_scroll_top = get_param(0, 1) - 1;
+            m_scroll_bottom = get_param(1, m_height) - 1;
+            this->set_cursor(0, 0);
+            this->count(sequence_kind::scroll, bytes);
+            break;
+         case 'S':
+            this->scroll(get_param(0, 1));
+            this->count(sequence_kind::scroll, bytes);
+            break;
+         case 'T':
+            this->scroll(-get_param(0, 1));
+            this->count(sequence_kind::scroll, bytes);
+            break;
+         default:
+            this->count(sequence_kind::unknown, bytes);
+            break;
+         }
+      }
+
+      // Returns the kind of the sequence. Mixed ones count as color
+      auto run_sgr(std::vector<int> params) -> sequence_kind
+      {
+         if (params.empty())
+            params.push_back(0);
+         sequence_kind kind = sequence_kind::style;
+         for (size_t i = 0; i < params.size(); ++i)
+         {
+            const int param = params[i];
+            if (param == 0)
+            {
+               m_format = cell_format{};
+            }
+            else if (param == 1 || param == 22)
+            {
+               m_format.m_bold = param == 1;
+            }
+            else if (param == 4 || param == 24)
+            {
+               m_format.m_underline = param == 4;
+            }
+            else if ((param == 38 || param == 48) && i + 1 < params.size())
+            {
+               kind = sequence_kind::color;
+               color& target = param == 38 ? m_format.m_fg_color : m_format.m_bg_color;
+               if (params[i + 1] == 2 && i + 4 < params.size())
+               {
+                  target = color{ params[i + 2], params[i + 3], params[i + 4] };
+                  i += 4;
+               }
+               else if (params[i + 1] == 5 && i + 2 < params.size())
+               {
+                  target = m_palette[params[i + 2] & 0xff];
+                  i += 2;
+               }
+            }
+            else
+            {
+               return sequence_kind::unknown;
+            }
+         }
+         return kind;
+      }
+
+      // Only OSC 4 with rgb:r/g/b is understood
+      auto end_osc(const size_t terminator_size) -> void
+      {
+         m_state = parse_state::ground;
+         const size_t bytes = 2 + m_sequence.size() + terminator_size;
+         const size_t rgb_pos = m_sequence.find(";rgb:");
+         if (m_sequence.starts_with("4;") == false || rgb_pos == std::string::npos)
+         {
+            this->count(sequence_kind::unknown, bytes);
+            return;
+         }
+         const int index = std::stoi(m_sequence.substr(2, rgb_pos - 2));
+         std::array<int, 3> components{};
+         size_t pos = rgb_pos + 5;
+         for (int& component : components)
+         {
+            const size_t end = m_sequence.find('/', pos);
+            component = std::stoi(m_sequence.substr(pos, end - pos), nullptr, 16);
+            pos = end + 1;
+         }
+         m_palette[index & 0xff] = color{ components[0], components[1], components[2] };
+         this->count(sequence_kind::palette, bytes);
+      }
+
+      auto set_cursor(const int column, const int line) -> void
+      {
+         m_column = std::clamp(column, 0, m_width - 1);
+         m_line = std::clamp(line, 0, m_height - 1);
+         m_pending_wrap = false;
+      }
+
+      // Writing into the last column doesn't move the cursor, the next letter wraps first
+      auto put_letter(const char_type letter) -> void
+      {
+         if (m_pending_wrap)
+         {
+            m_column = 0;
+            this->line_feed();
+         }
+         m_cells[static_cast<size_t>(m_line) * m_width + m_column] = cell_type{ letter, m_format };
+         if (m_column == m_width - 1)
+            m_pending_wrap = true;
+         else
+            ++m_column;
+      }
+
+      auto line_feed() -> void
+      {
+         m_pending_wrap = false;
+         if (m_line == m_scroll_bottom)
+            this->scroll(1);
+         else if (m_line < m_height - 1)
+            ++m_line;
+      }
+
+      // Positive amounts move the content of the scroll region up
+      auto scroll(const int amount) -> void
+      {
+         const int region_height = m_scroll_bottom - m_scroll_top + 1;
+         for (int i = 0; i < region_height; ++i)
+         {
+            const int target_line = amount > 0 ? m_scroll_top + i : m_scroll_bottom - i;
+            const int source_line = target_line + amount;
+            for (int column = 0; column < m_width; ++column)
+            {
+               cell_type& target = m_cells[static_cast<size_t>(target_line) * m_width + column];
+               if (source_line < m_scroll_top || source_line > m_scroll_bottom)
+                  target = get_blank_cell(m_format);
+               else
+                  target = m_cells[static_cast<size_t>(source_line) * m_width + column];
+            }
+         }
+      }
+
+      int m_width = 0;
+      int m_height = 0;
+      int m_column = 0;
+      int m_line = 0;
+      int m_saved_column = 0;
+      int m_saved_line = 0;
+      int m_scroll_top = 0;
+      int m_scroll_bottom = 0;
+      bool m_pending_wrap = false;
+      cell_format m_format{};
+      std::vector<cell_type> m_cells;
+      std::array<color, 256> m_palette{};
+      parse_state m_state = parse_state::ground;
+      std::string m_sequence; // Parameters of the current CSI or OSC
+      std::array<kind_stats, sequence_kind_count> m_stats{};
+   };
+
+} // namespace oof::testing